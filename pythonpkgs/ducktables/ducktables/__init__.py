@@ -1,13 +1,32 @@
 
-import inspect, sys
+import dataclasses, inspect, sys, typing
 from typing import Any, Optional, Dict, Iterable
 
 class DuckTableSchemaWrapper:
 
-    def __init__(self, func, names = None, types = None):
+    def __init__(self, func, names = None, types = None, batched = False):
         self.func = func
         self.types = types
         self.names = names
+        # Read by the extension, see ducktable()
+        self.pytables_batched = batched or getattr(func, 'pytables_batched', False)
+        self.partitions_func = getattr(func, 'partitions', None)
+        self.estimate_func = getattr(func, 'estimated_rows', None)
+
+    def partitioner(self, partitions_func):
+        """
+        Decorator registering a function that splits a call into partitions which DuckDB scans
+        in parallel. It is called with the table function's arguments and returns a list of
+        partition descriptors. The table function is then called once per descriptor, passed as
+        the 'partition' keyword argument, and must only produce that partition's rows.
+        """
+        self.partitions_func = partitions_func
+        return partitions_func
+
+    def partitions(self, *args, **kwargs):
+        if self.partitions_func:
+            return list(self.partitions_func(*args, **kwargs))
+        return None
 
     def column_names(self, *args, **kwargs):
         if self.names:
@@ -16,6 +35,9 @@ class DuckTableSchemaWrapper:
             return self.names_from_types(*args, **kwargs)
 
     def names_from_types(self, *args, **kwargs):
+        fields = self.row_fields()
+        if fields:
+            return [name for name, _ in fields]
         col_types = self.column_types(*args, **kwargs)
         if not col_types:
             return None
@@ -40,14 +62,76 @@ class DuckTableSchemaWrapper:
             # Second level which represents a row
             if hasattr(row_type, '__origin__') and issubclass(row_type.__origin__, Iterable):
                 col_types = row_type.__args__  # Column types
+                if self.pytables_batched:
+                    # Each column is a sequence of values, such as List[int]
+                    col_types = [getattr(typ, '__args__', (typ,))[0] for typ in col_types]
                 return list(col_types)
                 # return {f'column{i + 1}': typ for i, typ in enumerate(col_types)}
+        fields = self.row_fields()
+        if fields:
+            return [typ for _, typ in fields]
+        return None
+
+    def row_fields(self):
+        """
+        (name, type) of each field when the function is annotated as returning an iterable of
+        a NamedTuple or dataclass, None otherwise. These rows are read by attribute, so the
+        column names have to match the field names.
+        """
+        return_type = inspect.signature(self.func).return_annotation
+        if not (hasattr(return_type, '__origin__') and issubclass(return_type.__origin__, Iterable)):
+            return None
+        row_type = (getattr(return_type, '__args__', None) or (None,))[0]
+        if not isinstance(row_type, type):
+            return None
+        if dataclasses.is_dataclass(row_type):
+            names = [field.name for field in dataclasses.fields(row_type)]
+        elif issubclass(row_type, tuple) and hasattr(row_type, '_fields'):
+            names = list(row_type._fields)
+        else:
+            return None
+        hints = typing.get_type_hints(row_type)
+        if not all(name in hints for name in names):
+            return None
+        return [(name, hints[name]) for name in names]
+
+    def estimator(self, estimate_func):
+        """
+        Decorator registering a function that estimates how many rows a call will produce. It is
+        called with the table function's arguments, and helps DuckDB plan joins and report
+        progress. Returns None when there's no estimate.
+        """
+        self.estimate_func = estimate_func
+        return estimate_func
+
+    def estimated_rows(self, *args, **kwargs):
+        if self.estimate_func:
+            return self.estimate_func(*args, **kwargs)
         return None
 
+    def accepts_keyword(self, name):
+        """
+        True if the function names 'name' as one of its parameters. This is how functions opt
+        into hints from DuckDB, such as the 'columns' a query actually uses.
+        """
+        try:
+            parameters = inspect.signature(self.func).parameters
+        except (TypeError, ValueError):
+            return False
+        parameter = parameters.get(name)
+        return parameter is not None and parameter.kind in (
+            inspect.Parameter.POSITIONAL_OR_KEYWORD, inspect.Parameter.KEYWORD_ONLY)
+
     def __call__(self, *args, **kwargs):
         return self.func(*args, **kwargs)
 
-def ducktable(*args, **kwargs):
+def ducktable(*args, batched=False, **kwargs):
+    """
+    Declares a table function's columns, either by name or by name and type as keyword arguments.
+    With batched=True the function yields batches of columns instead of rows: a tuple with a
+    sequence of values per column, or a dict of such sequences by column name. All columns of a
+    batch have the same length, at most 2048 (DuckDB's vector size).
+    """
     if (1 == len(args)) and (0 == len(kwargs)) and callable(args[0]):
         # No arguments, this is the decorator
         # We just return the decorated function
@@ -63,6 +147,27 @@ def ducktable(*args, **kwargs):
             names = args
             types = None
         def decorator(func):
-            return DuckTableSchemaWrapper(func, names, types)
+            return DuckTableSchemaWrapper(func, names, types, batched)
         return decorator
 
+
+def buffers(func):
+    """
+    Marks a function called via pycall_vectorized() as accepting INTEGER, BIGINT and DOUBLE
+    columns as a (memoryview, validity) pair rather than a list. The memoryview is only valid
+    for the duration of the call. The validity is None when the column has no nulls, otherwise
+    a memoryview of 64 bit words where bit (i % 64) of word (i // 64) is set if row i is not null.
+    The function may return any buffer (such as a numpy array) matching its return type.
+    """
+    func.pytables_buffers = True
+    return func
+
+
+def memoize(func):
+    """
+    Marks a function called via pycall() as pure, so it is called once per distinct combination
+    of arguments in each query (per thread) and the result is reused for repeated arguments.
+    Hits and misses are reported by the pycall_memo_stats() table function.
+    """
+    func.pytables_memoize = True
+    return func
@@ -18,11 +18,19 @@ _ec2_instances_schema = {
     'private_ip': str,
     }
 @ducktable(**_ec2_instances_schema)
-def ec2_instances():
+def ec2_instances(columns=None):
     """
     SQL Usage:
     SELECT * FROM pytable('aws:ec2_instances'));
+
+    DuckDB passes the names of the columns a query uses as 'columns', and only those are yielded.
     """
+    names = list(_ec2_instances_schema)
+    projection = [names.index(c) for c in columns] if columns is not None else None
+
+    def project(row):
+        return row if projection is None else tuple(row[i] for i in projection)
+
     def response_to_rows(response):
         for resv in response['Reservations']:
             resv_id = resv['ReservationId']
@@ -33,7 +41,7 @@ def ec2_instances():
                     if pair['Key'] == 'Name':
                         instance_name = pair['Value']
                         break
-                yield (
+                yield project((
                     i['InstanceId'],
                     instance_name,
                     i['InstanceType'],
@@ -49,7 +57,7 @@ def ec2_instances():
                     i['PrivateDnsName'],
                     i['PrivateIpAddress'],
                     # i['HibernationOptions']['Configured'],
-                    )
+                    ))
     client = boto3.client('ec2')
     response = client.describe_instances()
     yield from response_to_rows(response)
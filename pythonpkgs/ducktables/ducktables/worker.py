@@ -0,0 +1,215 @@
+"""Runs Python functions on behalf of DuckDB's pytables extension in a separate process.
+
+pycall uses these workers when the pytables_isolation setting is 'process'. The extension
+starts each one as `python -m ducktables.worker`, with a socket on stdin that only carries
+message lengths and a shared memory region on file descriptor 3 that holds the messages
+themselves. See src/pyworker.cpp for the other side of the protocol.
+"""
+import importlib
+import mmap
+import os
+import struct
+
+SHM_FD = 3
+CONTROL_FD = 0
+
+# Length of the message and size of the shared memory region, in both directions
+HEADER = struct.Struct('=QQ')
+
+CALL, DESCRIBE = 1, 2
+OK, ERROR = 0, 1
+BOOLEAN, BIGINT, DOUBLE, VARCHAR = 1, 2, 3, 4
+
+CONVERTERS = {BOOLEAN: bool, BIGINT: int, DOUBLE: float, VARCHAR: str}
+BIGINT_MIN, BIGINT_MAX = -2**63, 2**63 - 1
+
+# Matches how the extension maps return annotations when running in process
+TYPE_NAMES = {int: 'BIGINT', float: 'DOUBLE', str: 'VARCHAR'}
+
+
+class SharedMemory:
+    def __init__(self, fd):
+        self.fd = fd
+        self.size = 0
+        self.map = None
+
+    def remap(self, size):
+        if size != self.size:
+            if self.map is not None:
+                self.map.close()
+            self.map = mmap.mmap(self.fd, size)
+            self.size = size
+
+    def reserve(self, size):
+        if size > self.size:
+            size = max(size, self.size * 2)
+            os.ftruncate(self.fd, size)
+            self.remap(size)
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def unpack(self, fmt):
+        values = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += struct.calcsize(fmt)
+        return values
+
+    def read(self, count):
+        data = self.data[self.pos:self.pos + count]
+        self.pos += count
+        return data
+
+    def string(self):
+        (count,) = self.unpack('=I')
+        return self.read(count).decode('utf-8')
+
+
+class Writer:
+    def __init__(self, shm):
+        self.shm = shm
+        self.pos = 0
+
+    def pack(self, fmt, *values):
+        size = struct.calcsize(fmt)
+        self.shm.reserve(self.pos + size)
+        struct.pack_into(fmt, self.shm.map, self.pos, *values)
+        self.pos += size
+
+    def write(self, data):
+        self.shm.reserve(self.pos + len(data))
+        self.shm.map[self.pos:self.pos + len(data)] = data
+        self.pos += len(data)
+
+    def string(self, value):
+        data = value.encode('utf-8')
+        self.pack('=I', len(data))
+        self.write(data)
+
+
+def read_column(reader, count):
+    """Reads one column: its type, a validity byte per row and the values."""
+    (kind,) = reader.unpack('=I')
+    validity = reader.read(count)
+    if kind == BOOLEAN:
+        values = [b != 0 for b in reader.read(count)]
+    elif kind == BIGINT:
+        values = reader.unpack('=%dq' % count)
+    elif kind == DOUBLE:
+        values = reader.unpack('=%dd' % count)
+    elif kind == VARCHAR:
+        offsets = reader.unpack('=%dQ' % (count + 1))
+        data = reader.read(offsets[-1])
+        values = [data[offsets[i]:offsets[i + 1]].decode('utf-8') for i in range(count)]
+    else:
+        raise ValueError("Unknown column type %d" % kind)
+    return [value if valid else None for value, valid in zip(values, validity)]
+
+
+def convert(kind, value):
+    """Converts a result to the column's type, values that can't be converted become null."""
+    if value is None:
+        return None
+    try:
+        value = CONVERTERS[kind](value)
+    except (TypeError, ValueError, OverflowError):
+        return None
+    if kind == BIGINT and not (BIGINT_MIN <= value <= BIGINT_MAX):
+        return None
+    return value
+
+
+def write_column(writer, kind, values):
+    values = [convert(kind, value) for value in values]
+    writer.pack('=I', kind)
+    writer.write(bytes(0 if value is None else 1 for value in values))
+    if kind == BOOLEAN:
+        writer.write(bytes(1 if value else 0 for value in values))
+    elif kind == BIGINT:
+        writer.pack('=%dq' % len(values), *(value or 0 for value in values))
+    elif kind == DOUBLE:
+        writer.pack('=%dd' % len(values), *(value or 0.0 for value in values))
+    else:
+        encoded = [b'' if value is None else value.encode('utf-8') for value in values]
+        offsets = [0]
+        for data in encoded:
+            offsets.append(offsets[-1] + len(data))
+        writer.pack('=%dQ' % len(offsets), *offsets)
+        writer.write(b''.join(encoded))
+
+
+def resolve(functions, specifier):
+    func = functions.get(specifier)
+    if func is None:
+        if ':' not in specifier:
+            raise ValueError("Function specifier lacks a ':' to delineate module and function")
+        module_name, func_name = specifier.split(':', 1)
+        module = importlib.import_module(module_name)
+        func = getattr(module, func_name)
+        functions[specifier] = func
+    return func
+
+
+def describe(func):
+    annotation = getattr(func, '__annotations__', {}).get('return')
+    if isinstance(annotation, str):
+        return annotation
+    return TYPE_NAMES.get(annotation, '')
+
+
+def handle(shm, functions, length):
+    """Handles one request, returning a Writer holding the response."""
+    # Copied out, so the response can be written over the request
+    reader = Reader(shm.map[:length])
+    writer = Writer(shm)
+    try:
+        (message,) = reader.unpack('=I')
+        func = resolve(functions, reader.string())
+        if message == DESCRIBE:
+            type_name = describe(func)
+            writer.pack('=I', OK)
+            writer.string(type_name)
+        else:
+            result_kind, column_count, row_count = reader.unpack('=IIQ')
+            columns = [read_column(reader, row_count) for _ in range(column_count)]
+            if columns:
+                results = [func(*row) for row in zip(*columns)]
+            else:
+                results = [func() for _ in range(row_count)]
+            writer.pack('=I', OK)
+            write_column(writer, result_kind, results)
+    except Exception as e:
+        writer = Writer(shm)
+        writer.pack('=I', ERROR)
+        writer.string(str(e))
+    return writer
+
+
+def read_exactly(fd, count):
+    data = b''
+    while len(data) < count:
+        chunk = os.read(fd, count - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return data
+
+
+def main():
+    shm = SharedMemory(SHM_FD)
+    functions = {}
+    while True:
+        header = read_exactly(CONTROL_FD, HEADER.size)
+        if header is None:
+            # The extension closed our socket
+            return
+        length, size = HEADER.unpack(header)
+        shm.remap(size)
+        writer = handle(shm, functions, length)
+        os.write(CONTROL_FD, HEADER.pack(writer.pos, shm.size))
+
+
+if __name__ == '__main__':
+    main()
@@ -1,8 +1,9 @@
 
 from unittest import TestCase
-from ducktables import ducktable, DuckTableSchemaWrapper
+from ducktables import ducktable, buffers, memoize, DuckTableSchemaWrapper
 
-from typing import Iterator, Tuple, List, Dict
+import dataclasses
+from typing import Iterator, Iterable, Tuple, List, Dict, NamedTuple
 
 # Table function that will be the basis for all of our tests. Strategy is to
 # create other functions that delegate to this function so we have consistent
@@ -158,3 +159,165 @@ class TestDuckTableSchemaWrapper(TestCase):
             (2, 'o'),
             ]
         self.assertEqual(rows, expected_rows)
+
+
+class Person(NamedTuple):
+    name: str
+    age: int
+
+
+@dataclasses.dataclass
+class Point:
+    x: float
+    y: float
+
+
+class TestRowFields(TestCase):
+
+    def test_named_tuple_rows(self):
+        @ducktable
+        def people() -> Iterable[Person]:
+            yield Person('Jane', 42)
+
+        self.assertEqual(['name', 'age'], people.column_names())
+        self.assertEqual([str, int], people.column_types())
+
+    def test_dataclass_rows(self):
+        @ducktable
+        def points() -> Iterator[Point]:
+            yield Point(1.0, 2.0)
+
+        self.assertEqual(['x', 'y'], points.column_names())
+        self.assertEqual([float, float], points.column_types())
+
+    def test_explicit_names_override_fields(self):
+        @ducktable('a', 'b')
+        def people() -> Iterable[Person]:
+            yield Person('Jane', 42)
+
+        self.assertEqual(('a', 'b'), people.column_names())
+
+    def test_plain_rows_have_no_fields(self):
+        @ducktable
+        def chars(input) -> Iterator[Tuple[int, str]]:
+            return index_chars(input)
+
+        self.assertIsNone(chars.row_fields())
+
+
+class TestBatched(TestCase):
+
+    def test_not_batched_by_default(self):
+        @ducktable
+        def chars(input):
+            return index_chars(input)
+
+        self.assertFalse(chars.pytables_batched)
+
+    def test_batched_with_column_types(self):
+        @ducktable(batched=True)
+        def batches(input) -> Iterator[Tuple[List[int], List[str]]]:
+            yield ([0, 1], ['a', 'b'])
+
+        self.assertTrue(batches.pytables_batched)
+        self.assertEqual([int, str], batches.column_types())
+        self.assertEqual(['column1', 'column2'], batches.column_names())
+
+    def test_batched_with_names(self):
+        @ducktable('i', 'c', batched=True)
+        def batches(input):
+            yield ([0, 1], ['a', 'b'])
+
+        self.assertTrue(batches.pytables_batched)
+        self.assertEqual(('i', 'c'), batches.column_names())
+
+
+class TestBuffers(TestCase):
+
+    def test_sets_flag(self):
+        @buffers
+        def add_one(values) -> float:
+            data, validity = values
+            return [v + 1 for v in data]
+
+        self.assertTrue(add_one.pytables_buffers)
+        self.assertEqual([2, 3], add_one(([1, 2], None)))
+
+
+class TestMemoize(TestCase):
+
+    def test_sets_flag(self):
+        @memoize
+        def country_name(code) -> str:
+            return {'NZ': 'New Zealand'}.get(code)
+
+        self.assertTrue(country_name.pytables_memoize)
+        self.assertEqual('New Zealand', country_name('NZ'))
+
+
+class TestPartitions(TestCase):
+
+    def test_no_partitioner(self):
+        @ducktable
+        def unpartitioned(input):
+            return index_chars(input)
+
+        self.assertIsNone(unpartitioned.partitions('foo'))
+
+    def test_partitioner(self):
+        @ducktable(index=int, charval=str)
+        def by_word(sentence, partition=None):
+            return index_chars(partition)
+
+        @by_word.partitioner
+        def words(sentence):
+            return sentence.split()
+
+        self.assertEqual(['ab', 'c'], by_word.partitions('ab c'))
+        self.assertEqual([(0, 'c')], list(by_word('ab c', partition='c')))
+
+    def test_partitions_attribute(self):
+        def split(sentence, partition=None):
+            return index_chars(partition)
+        split.partitions = lambda sentence: (w for w in sentence.split())
+
+        self.assertEqual(['ab', 'c'], ducktable(split).partitions('ab c'))
+
+
+class TestAcceptsKeyword(TestCase):
+
+    def test_accepts_keyword(self):
+        @ducktable
+        def projected(input, columns=None):
+            return index_chars(input)
+
+        self.assertTrue(projected.accepts_keyword('columns'))
+        self.assertFalse(projected.accepts_keyword('filters'))
+
+    def test_var_keyword_does_not_count(self):
+        @ducktable
+        def anything(input, **kwargs):
+            return index_chars(input)
+
+        self.assertFalse(anything.accepts_keyword('columns'))
+
+
+class TestEstimatedRows(TestCase):
+
+    def test_no_estimator(self):
+        @ducktable
+        def unknown(input):
+            return index_chars(input)
+
+        self.assertIsNone(unknown.estimated_rows('foo'))
+
+    def test_estimator(self):
+        @ducktable
+        def chars(input):
+            return index_chars(input)
+
+        @chars.estimator
+        def count_chars(input):
+            return len(input)
+
+        self.assertEqual(3, chars.estimated_rows('foo'))
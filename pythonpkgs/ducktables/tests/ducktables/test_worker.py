@@ -0,0 +1,73 @@
+import os
+import tempfile
+from unittest import TestCase
+
+from ducktables import worker
+
+
+def shout(s: str, times: int) -> str:
+    return s.upper() * times if s is not None else None
+
+
+def fails(x):
+    raise ValueError("no good: %s" % x)
+
+
+class TestWorker(TestCase):
+
+    def setUp(self):
+        fd, path = tempfile.mkstemp()
+        os.unlink(path)
+        self.shm = worker.SharedMemory(fd)
+        os.ftruncate(fd, 64)
+        self.shm.remap(64)
+        self.functions = {'test:shout': shout, 'test:fails': fails}
+
+    def tearDown(self):
+        self.shm.map.close()
+        os.close(self.shm.fd)
+
+    def request(self, message, specifier, *rest):
+        writer = worker.Writer(self.shm)
+        writer.pack('=I', message)
+        writer.string(specifier)
+        for fmt, values in rest:
+            writer.pack(fmt, *values)
+        return worker.handle(self.shm, self.functions, writer.pos)
+
+    def response(self, writer):
+        return worker.Reader(self.shm.map[:writer.pos])
+
+    def test_call(self):
+        writer = worker.Writer(self.shm)
+        writer.pack('=I', worker.CALL)
+        writer.string('test:shout')
+        writer.pack('=IIQ', worker.VARCHAR, 2, 3)
+        worker.write_column(writer, worker.VARCHAR, ['a', None, 'long enough to grow the region' * 4])
+        worker.write_column(writer, worker.BIGINT, [1, 2, 3])
+        response = worker.handle(self.shm, self.functions, writer.pos)
+
+        reader = self.response(response)
+        self.assertEqual(reader.unpack('=I'), (worker.OK,))
+        self.assertEqual(worker.read_column(reader, 3), ['A', None, 'LONG ENOUGH TO GROW THE REGION' * 12])
+
+    def test_error(self):
+        writer = worker.Writer(self.shm)
+        writer.pack('=I', worker.CALL)
+        writer.string('test:fails')
+        writer.pack('=IIQ', worker.VARCHAR, 1, 1)
+        worker.write_column(writer, worker.DOUBLE, [1.5])
+        reader = self.response(worker.handle(self.shm, self.functions, writer.pos))
+        self.assertEqual(reader.unpack('=I'), (worker.ERROR,))
+        self.assertEqual(reader.string(), 'no good: 1.5')
+
+    def test_describe(self):
+        reader = self.response(self.request(worker.DESCRIBE, 'test:shout'))
+        self.assertEqual(reader.unpack('=I'), (worker.OK,))
+        self.assertEqual(reader.string(), 'VARCHAR')
+
+    def test_unconvertible_results_are_null(self):
+        writer = worker.Writer(self.shm)
+        worker.write_column(writer, worker.BIGINT, [1, 'x', 2**70, None, True])
+        reader = worker.Reader(self.shm.map[:writer.pos])
+        self.assertEqual(worker.read_column(reader, 5), [1, None, None, None, 1])
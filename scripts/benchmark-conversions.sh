@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# Measures how many values per second are converted between DuckDB and Python, per type and in
+# both directions: pytable rows of four Python values written into DuckDB columns, and pycall
+# calls with four DuckDB arguments read into Python. Set BASELINE to the path of another duckdb
+# binary, such as one built from an earlier commit, to measure it alongside this build.
+
+set -e;
+
+if [ -z "$BUILD_TARGET" ]; then
+    BUILD_TARGET=release
+fi
+DUCKDB=./build/$BUILD_TARGET/duckdb
+
+if [ -z "$ROWS" ]; then
+    ROWS=1000000
+fi
+
+export PYTHONPATH=pythonpkgs/ducktables/:.
+
+declare -A TYPES=([int]=BIGINT [float]=DOUBLE [str]=VARCHAR [date]=DATE)
+declare -A VALUES=([int]="i" [float]="i::DOUBLE" [str]="i::VARCHAR" [date]="DATE '2000-01-01' + (i % 10000)::INTEGER")
+
+measure() {
+    local binary=$1 sql=$2
+    start=$(date +%s.%N)
+    $binary -c "SET threads=1; $sql" > /dev/null
+    end=$(date +%s.%N)
+    echo "$ROWS * 4 / ($end - $start)" | bc
+}
+
+echo "build,direction,type,values_per_second"
+for build in $DUCKDB $BASELINE; do
+    for kind in int float str date; do
+        type=${TYPES[$kind]}
+        columns="{'a': '$type', 'b': '$type', 'c': '$type', 'd': '$type'}"
+        rate=$(measure $build "SELECT count(*) FROM pytable('udfs:benchmark_rows', '$kind', $ROWS, columns=$columns) WHERE a IS NOT NULL;")
+        echo "$build,python_to_duckdb,$type,$rate"
+
+        rate=$(measure $build "SELECT sum(pycall('udfs:count_args', v, v, v, v)) FROM (SELECT ${VALUES[$kind]} AS v FROM range($ROWS) t(i));")
+        echo "$build,duckdb_to_python,$type,$rate"
+    done
+done
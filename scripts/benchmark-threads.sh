@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Times a pure Python scalar function at increasing DuckDB thread counts, once with every
+# thread sharing the main interpreter's GIL and once with a sub-interpreter per thread (which
+# requires the extension to be built with 'make release SUBINTERPRETERS=1' against Python 3.12 or
+# newer).
+
+set -e;
+
+if [ -z "$BUILD_TARGET" ]; then
+    BUILD_TARGET=release
+fi
+DUCKDB=./build/$BUILD_TARGET/duckdb
+
+if [ -z "$MAX_THREADS" ]; then
+    MAX_THREADS=$(nproc)
+fi
+
+if [ -z "$ROWS" ]; then
+    ROWS=2000000
+fi
+
+if [ -z "$UDF" ]; then
+    UDF=udfs:fizzbuzz
+fi
+
+export PYTHONPATH=pythonpkgs/ducktables/:.
+
+echo "isolation,threads,seconds"
+for isolation in none subinterpreter; do
+    threads=1
+    while [ $threads -le $MAX_THREADS ]; do
+        start=$(date +%s.%N)
+        $DUCKDB -c "SET threads=$threads; SET pytables_isolation='$isolation'; SELECT count(*) FROM (SELECT pycall('$UDF', i::INTEGER) AS r FROM range($ROWS) t(i)) WHERE r = 'fizz';" > /dev/null
+        end=$(date +%s.%N)
+        echo "$isolation,$threads,$(echo "$end - $start" | bc)"
+        threads=$((threads * 2))
+    done
+done
@@ -0,0 +1,12 @@
+
+#include <Python.h>
+#include <cpy/gil.hpp>
+
+namespace cpy {
+GIL::GIL() : state(PyGILState_Ensure()) {
+}
+
+GIL::~GIL() {
+	PyGILState_Release(state);
+}
+} // namespace cpy
@@ -4,5 +4,6 @@
 #include <cpy/object.hpp>
 #include <cpy/module.hpp>
 #include <cpy/function.hpp>
+#include <cpy/gil.hpp>
 
 #endif // CPY_HPP
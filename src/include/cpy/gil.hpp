@@ -0,0 +1,21 @@
+
+#ifndef CPY_GIL_HPP
+#define CPY_GIL_HPP
+
+#include <Python.h>
+
+namespace cpy {
+// Holds the GIL for the lifetime of the object. Safe to nest, and safe to use from
+// threads the interpreter has never seen before (such as DuckDB's worker threads).
+class GIL {
+public:
+	GIL();
+	~GIL();
+	GIL(const GIL &) = delete;
+	GIL &operator=(const GIL &) = delete;
+
+private:
+	PyGILState_STATE state;
+};
+} // namespace cpy
+#endif // CPY_GIL_HPP
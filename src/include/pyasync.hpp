@@ -0,0 +1,18 @@
+#pragma once
+
+#include <Python.h>
+#include <duckdb.hpp>
+
+namespace pyudf {
+// Calls an 'async def' function once per tuple in the 'argument_tuples' list, running at most
+// 'concurrency' of the calls at a time on this thread's event loop. Returns a new list of the
+// results in the same order, or nullptr with the Python error set if any call raised.
+PyObject *GatherAsync(PyObject *function, PyObject *argument_tuples, duckdb::idx_t concurrency);
+
+// True if the object is an async iterable (such as an async generator) rather than an iterable
+bool IsAsyncIterable(PyObject *obj);
+
+// Wraps an async iterable in a (new reference to a) regular iterator, driving it on an event
+// loop of its own. Returns nullptr with the Python error set on failure.
+PyObject *IterateAsync(PyObject *async_iterable);
+} // namespace pyudf
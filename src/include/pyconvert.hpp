@@ -6,10 +6,104 @@
 namespace pyudf {
 PyObject *duckdb_to_py(duckdb::Value &value);
 PyObject *duckdbs_to_pys(std::vector<duckdb::Value> &values);
+PyObject *VectorToPyList(duckdb::Vector &vector, duckdb::idx_t count);
+
+// The Python classes DATE, TIME, TIMESTAMP, DECIMAL and UUID values become, looked up in the
+// current interpreter's modules the first time a value needs them. Meant to live for one chunk,
+// during which the interpreter can't change, so a thread that runs functions both in the main
+// interpreter and in a sub-interpreter never mixes up their classes. Requires the GIL throughout.
+class PyClasses {
+public:
+	// UTC is the datetime.timezone.utc instance rather than a class
+	enum Class : uint8_t { DATE, TIME, DATETIME, UTC, DECIMAL, UUID, CLASS_COUNT };
+
+	PyClasses() = default;
+	PyClasses(const PyClasses &) = delete;
+	PyClasses &operator=(const PyClasses &) = delete;
+	~PyClasses();
+
+	// Borrowed reference, nullptr with the Python error set if the module can't be imported
+	PyObject *Get(Class cls);
+
+private:
+	PyObject *classes[CLASS_COUNT] = {};
+};
+
+// Converts row 'row' of a vector to a new Python object, None for nulls. 'format' is the vector's
+// unified format and 'classes' the classes of the current interpreter, both set up once per chunk.
+// Picked once per column with GetColumnReader().
+typedef PyObject *(*py_column_reader_t)(duckdb::Vector &vector, duckdb::UnifiedVectorFormat &format,
+                                        PyClasses &classes, duckdb::idx_t row);
+py_column_reader_t GetColumnReader(const duckdb::LogicalType &logical_type);
+std::vector<py_column_reader_t> GetColumnReaders(const std::vector<duckdb::LogicalType> &logical_types);
+
+// Converts rows of a chunk's columns, from 'first_column' on, to tuples of Python objects using
+// one reader per column
+class PyRowReader {
+public:
+	PyRowReader(const std::vector<py_column_reader_t> &readers, duckdb::DataChunk &chunk, duckdb::idx_t first_column);
+
+	// New reference
+	PyObject *Row(duckdb::idx_t row);
+
+private:
+	const std::vector<py_column_reader_t> &readers;
+	duckdb::DataChunk &chunk;
+	duckdb::idx_t first_column;
+	std::vector<duckdb::UnifiedVectorFormat> formats;
+	PyClasses classes;
+};
+
+// Read-only (memoryview, validity) pair over the data of an INTEGER/BIGINT/DOUBLE vector, nullptr for
+// other types. The views must be released with ReleasePyBuffer() before the vector goes away.
+PyObject *VectorToPyBuffer(duckdb::Vector &vector, duckdb::idx_t count);
+bool ReleasePyBuffer(PyObject *py_buffer);
+
+// Copies an object supporting the buffer protocol into a numeric vector, returns false if the
+// object isn't a buffer or the vector type has no buffer representation.
+bool PyBufferToVector(PyObject *py_object, duckdb::Vector &result, duckdb::idx_t count);
 PyObject *StructToDict(duckdb::Value value);
-duckdb::Value ConvertPyObjectToDuckDBValue(PyObject *py_item, duckdb::LogicalType logical_type);
-void ConvertPyObjectsToDuckDBValues(PyObject *py_iterator, std::vector<duckdb::LogicalType> logical_types,
-                                    std::vector<duckdb::Value> &result);
+duckdb::Value ConvertPyObjectToDuckDBValue(PyObject *py_item, const duckdb::LogicalType &logical_type);
+
+// Writes a Python object straight into row 'row' of a flat vector, or marks the row null if the
+// object can't be converted to the vector's type. Picked once per column with GetColumnWriter().
+typedef void (*py_column_writer_t)(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row);
+py_column_writer_t GetColumnWriter(const duckdb::LogicalType &logical_type);
+std::vector<py_column_writer_t> GetColumnWriters(const std::vector<duckdb::LogicalType> &logical_types);
+
+// Writes the i-th value of a row iterator into row 'row' of output column output_columns[i] using
+// writers[i]. Values with a null writer aren't projected and are skipped.
+void WritePyRow(PyObject *py_iterator, const std::vector<py_column_writer_t> &writers,
+                const std::vector<duckdb::idx_t> &output_columns, duckdb::DataChunk &output, duckdb::idx_t row);
+
+// How WritePyRowObject() finds the values of a row
+enum class PyRowKind : uint8_t { SEQUENCE, MAPPING, ATTRIBUTES, ITERABLE };
+
+// Column names for rows read by key (dicts) or by attribute (NamedTuples, dataclasses), as
+// interned strings parallel to the writers. Also remembers the kind of the last row type seen,
+// so a row's type is only inspected when it changes. Requires the GIL throughout.
+struct PyRowKeys {
+	std::vector<PyObject *> names;
+	PyObject *row_type = nullptr;
+	PyRowKind row_kind = PyRowKind::ITERABLE;
+
+	void Append(const std::string &name);
+	void Release();
+};
+
+// Same as WritePyRow() for a row object: tuples and lists are read by index, dicts by key,
+// dataclasses and NamedTuples whose fields are the columns by attribute, and any other iterable
+// through its iterator. Keys a dict lacks are written as nulls, missing attributes are an error.
+void WritePyRowObject(PyObject *py_row, const std::vector<py_column_writer_t> &writers,
+                      const std::vector<duckdb::idx_t> &output_columns, PyRowKeys &keys,
+                      duckdb::DataChunk &output, duckdb::idx_t row);
+
+// Appends a batch yielded by a batched function to the output: a tuple with one sequence of values
+// per column, or a dict of such sequences by column name. Returns the number of rows, and throws if
+// the columns differ in length or the batch doesn't fit into the output.
+duckdb::idx_t WritePyBatch(PyObject *py_batch, const std::vector<py_column_writer_t> &writers,
+                           const std::vector<duckdb::idx_t> &output_columns, PyRowKeys &keys,
+                           duckdb::DataChunk &output);
 PyObject *pyObjectToIterable(PyObject *py_object);
 std::vector<duckdb::LogicalType> PyTypesToLogicalTypes(const std::vector<PyObject *> &pyTypes);
 
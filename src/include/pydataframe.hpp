@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Python.h>
+#include <duckdb.hpp>
+#include <pyconvert.hpp>
+#include <string>
+#include <vector>
+
+namespace pyudf {
+// True for objects implementing the dataframe interchange protocol (__dataframe__()), such as
+// pandas DataFrames
+bool IsPyDataFrame(PyObject *py_object);
+
+struct PyDataFrameColumn {
+	std::string name;
+	duckdb::LogicalType type;
+
+	// Interchange dtype of numeric, boolean and datetime columns, which are read straight from
+	// their buffers
+	int64_t kind = -1;
+	int64_t bit_width = 0;
+	char unit = 0;
+
+	// Columns of any other dtype (strings, categoricals, ...) are read as a list of Python objects,
+	// converted when a scan projects them
+	bool objects = false;
+};
+
+// A dataframe a table function returned, with the names and types of its columns. Requires the
+// GIL for construction and destruction.
+class PyDataFrame {
+public:
+	// Takes its own reference to the object implementing __dataframe__()
+	explicit PyDataFrame(PyObject *source);
+	~PyDataFrame();
+
+	std::vector<PyDataFrameColumn> columns;
+
+	// The interchange dataframe returned by __dataframe__()
+	PyObject *interchange = nullptr;
+
+	// Number of rows, INVALID_INDEX if the dataframe doesn't know
+	duckdb::idx_t row_count = duckdb::DConstants::INVALID_INDEX;
+
+	// New reference to the whole of an object column as a list
+	PyObject *ColumnObjects(const PyDataFrameColumn &column) const;
+
+private:
+	PyObject *source = nullptr;
+};
+
+// The buffers of one column of the interchange chunk being scanned
+struct PyBufferColumn {
+	// The get_buffers() dict, which keeps the memory alive
+	PyObject *buffers = nullptr;
+	duckdb::const_data_ptr_t data = nullptr;
+	duckdb::const_data_ptr_t validity = nullptr;
+	int64_t null_kind = 0;
+	int64_t null_value = 0;
+	duckdb::idx_t offset = 0;
+};
+
+// Reads a dataframe's chunks a vector at a time, converting the projected columns only.
+// Requires the GIL throughout.
+class PyDataFrameScan {
+public:
+	PyDataFrameScan(PyDataFrame &dataframe, const std::vector<duckdb::column_t> &column_ids);
+	~PyDataFrameScan();
+
+	// Fills the output with the next rows, returns false once there are none left
+	bool Scan(duckdb::DataChunk &output);
+
+private:
+	bool NextChunk();
+	void ReleaseChunk();
+
+	PyDataFrame &dataframe;
+	std::vector<duckdb::column_t> column_ids;
+	std::vector<py_column_writer_t> writers;
+
+	// List of the interchange chunks, the index of the current one and the rows read from it
+	PyObject *chunks = nullptr;
+	duckdb::idx_t chunk_index = 0;
+	duckdb::idx_t chunk_rows = 0;
+	duckdb::idx_t chunk_position = 0;
+
+	// Rows of earlier chunks, so object columns can be indexed across chunks
+	duckdb::idx_t chunk_start = 0;
+
+	// Values of the projected object columns, by output column
+	std::vector<PyObject *> object_columns;
+
+	// Buffers of the projected buffer columns in the current chunk, by output column
+	std::vector<PyBufferColumn> buffer_columns;
+};
+} // namespace pyudf
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Python.h>
+#include <string>
+#include <unordered_map>
+
+namespace pyudf {
+// A Python sub-interpreter with its own GIL (PEP 684), created lazily for each DuckDB thread
+// that runs a pycall function with pytables_isolation = 'subinterpreter' and ended when that
+// thread exits. Modules are imported separately in every interpreter, so objects must never be
+// passed between them.
+class SubInterpreter {
+public:
+	// Whether the extension was built with PYTABLES_SUBINTERPRETERS against a Python that
+	// supports a GIL per interpreter (3.12+)
+	static bool Supported();
+
+	// Ends the interpreter, from the thread that owns it while that thread holds no GIL
+	~SubInterpreter();
+
+	// Switches the calling thread into its sub-interpreter, creating it on first use, and holds
+	// that interpreter's GIL for the lifetime of the scope. The thread must not hold the main
+	// interpreter's GIL.
+	class Scope {
+	public:
+		Scope();
+		~Scope();
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+		SubInterpreter &interpreter;
+	};
+
+	// Resolves a 'module:func' specifier within this interpreter, importing the module the first
+	// time it is used. Returns a borrowed reference that lives as long as the interpreter.
+	PyObject *function(const std::string &function_specifier);
+
+private:
+	static SubInterpreter &ForCurrentThread();
+
+	PyThreadState *thread_state = nullptr;
+	std::unordered_map<std::string, PyObject *> functions;
+};
+} // namespace pyudf
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <duckdb.hpp>
+#include <duckdb/parser/parsed_data/create_table_function_info.hpp>
+#include <duckdb/storage/object_cache.hpp>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pyudf {
+// Hits and misses of memoized pycall functions, kept per database for pycall_memo_stats()
+class PyMemoStats : public duckdb::ObjectCacheEntry {
+public:
+	static duckdb::shared_ptr<PyMemoStats> Get(duckdb::ClientContext &context);
+
+	void Record(const std::string &function, duckdb::idx_t hits, duckdb::idx_t misses);
+
+	// Function specifier, hits and misses of each memoized function
+	std::vector<std::tuple<std::string, duckdb::idx_t, duckdb::idx_t>> Counters();
+
+	static std::string ObjectType() {
+		return "pycall_memo_stats";
+	}
+	std::string GetObjectType() override {
+		return ObjectType();
+	}
+
+private:
+	std::mutex lock;
+	std::unordered_map<std::string, std::pair<duckdb::idx_t, duckdb::idx_t>> counters;
+};
+
+// Results of a memoized pycall function keyed by the raw bytes of its DuckDB arguments, for the
+// lifetime of one expression state. Repeated arguments skip both the conversion to Python and
+// the call, and looking a row up doesn't box any of its values.
+class PyMemo {
+public:
+	// Entries beyond this are not stored, so high cardinality inputs can't exhaust memory
+	static constexpr duckdb::idx_t MAX_ENTRIES = 100000;
+
+	explicit PyMemo(duckdb::shared_ptr<PyMemoStats> stats) : stats(std::move(stats)) {
+	}
+
+	// Whether values of the type can be part of a key or a result: fixed size types and strings
+	static bool Supports(const duckdb::LogicalType &type);
+
+	// Reads the arguments of the rows looked up until the next call
+	void SetArguments(duckdb::DataChunk &args);
+
+	// Writes the remembered result for the row's arguments, returns false if there is none
+	bool Lookup(duckdb::idx_t row, duckdb::Vector &result);
+
+	// Remembers the result just written to the row
+	void Store(duckdb::idx_t row, duckdb::Vector &result);
+
+	// Adds the counters of the chunks since the last flush to the database's totals
+	void Flush(const std::string &function);
+
+	// The encoded arguments of a row, valid until the next row is looked up
+	const std::string &RowKey(duckdb::idx_t row);
+
+	// Copies the result of one row of a flat vector to another
+	static void CopyResult(duckdb::Vector &result, duckdb::idx_t source, duckdb::idx_t target);
+
+private:
+	// Encodes the arguments of a row into 'key', unless it already holds them
+	void BuildKey(duckdb::idx_t row);
+
+	std::vector<duckdb::UnifiedVectorFormat> arguments;
+	std::vector<duckdb::idx_t> argument_sizes;
+
+	// Reused between rows, so building a key doesn't allocate once it has grown
+	std::string key;
+	duckdb::idx_t key_row = duckdb::DConstants::INVALID_INDEX;
+
+	// Results encoded as a validity byte followed by the value's bytes
+	std::unordered_map<std::string, std::string> results;
+	duckdb::idx_t hits = 0;
+	duckdb::idx_t misses = 0;
+	duckdb::shared_ptr<PyMemoStats> stats;
+};
+
+duckdb::unique_ptr<duckdb::CreateTableFunctionInfo> GetPyMemoStatsFunction();
+} // namespace pyudf
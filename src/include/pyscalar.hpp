@@ -4,4 +4,5 @@
 
 namespace pyudf {
 duckdb::CreateScalarFunctionInfo GetPythonScalarFunction();
+duckdb::CreateScalarFunctionInfo GetPythonVectorizedScalarFunction();
 }
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <duckdb.hpp>
+#include <string>
+
+namespace pyudf {
+// How pycall runs Python functions, see the 'pytables_isolation' setting
+enum class PyIsolation { NONE, SUBINTERPRETER, PROCESS };
+
+void RegisterSettings(duckdb::DBConfig &config);
+
+PyIsolation GetIsolation(duckdb::ClientContext &context);
+
+// Upper bound on the number of Python worker processes for pytables_isolation = 'process'
+duckdb::idx_t GetWorkerProcesses(duckdb::ClientContext &context);
+
+// Seconds that pytable results stay cached, 0 when the cache is off
+duckdb::idx_t GetCacheTTL(duckdb::ClientContext &context);
+
+// Bytes of memory that cached pytable results may use
+duckdb::idx_t GetCacheSize(duckdb::ClientContext &context);
+
+// Calls of an 'async def' pycall function that may be in flight at once on one thread
+duckdb::idx_t GetAsyncConcurrency(duckdb::ClientContext &context);
+
+// Chunks pytable may read ahead of the query, 0 when prefetching is off
+duckdb::idx_t GetPrefetchChunks(duckdb::ClientContext &context);
+
+// Bytes of memory that chunks read ahead of the query may hold
+duckdb::idx_t GetPrefetchMemory(duckdb::ClientContext &context);
+} // namespace pyudf
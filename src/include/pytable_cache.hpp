@@ -0,0 +1,58 @@
+#pragma once
+
+#include <duckdb.hpp>
+#include <duckdb/common/types/column/column_data_collection.hpp>
+#include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
+#include <duckdb/parser/parsed_data/create_table_function_info.hpp>
+#include <duckdb/storage/object_cache.hpp>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pyudf {
+// Every row of a completed pytable scan, replayed by later scans of the same call
+struct PyTableCacheEntry {
+	std::string function;
+	std::string arguments;
+	std::vector<duckdb::LogicalType> types;
+	std::vector<std::string> names;
+	duckdb::shared_ptr<duckdb::ColumnDataCollection> rows;
+	std::chrono::steady_clock::time_point created;
+	duckdb::idx_t hits = 0;
+
+	double AgeSeconds() const;
+};
+
+// Results of pytable calls, kept per database in DuckDB's object cache while the
+// pytables_cache_ttl setting is non-zero. Rows live in buffer managed memory.
+class PyTableCache : public duckdb::ObjectCacheEntry {
+public:
+	static duckdb::shared_ptr<PyTableCache> Get(duckdb::ClientContext &context);
+
+	// The entry for a call if there is one younger than 'ttl' seconds
+	duckdb::shared_ptr<PyTableCacheEntry> Lookup(const std::string &key, duckdb::idx_t ttl);
+
+	// Adds an entry, evicting the oldest ones to stay below 'max_size' bytes
+	void Insert(const std::string &key, duckdb::shared_ptr<PyTableCacheEntry> entry, duckdb::idx_t max_size);
+
+	// Removes the entries of a 'module:func' function, or every entry if it's empty
+	duckdb::idx_t Evict(const std::string &function);
+
+	std::vector<duckdb::shared_ptr<PyTableCacheEntry>> Entries();
+
+	static std::string ObjectType() {
+		return "pytables_cache";
+	}
+	std::string GetObjectType() override {
+		return ObjectType();
+	}
+
+private:
+	std::mutex lock;
+	std::unordered_map<std::string, duckdb::shared_ptr<PyTableCacheEntry>> entries;
+};
+
+duckdb::unique_ptr<duckdb::CreateTableFunctionInfo> GetPyTableCacheFunction();
+duckdb::CreateScalarFunctionInfo GetPyTableCacheClearFunction();
+} // namespace pyudf
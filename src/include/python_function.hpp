@@ -26,6 +26,20 @@ public:
 		return module_name_;
 	}
 
+	// True if the function object has the named attribute set to a truthy value
+	bool has_flag(const std::string &attr_name) const;
+
+	// The function's 'return' type annotation as a new reference, nullptr if it has none
+	PyObject *return_annotation() const;
+
+	// True for 'async def' functions, whose calls return coroutines
+	bool is_coroutine_function() const;
+
+	// Borrowed reference to the callable
+	PyObject *callable() const {
+		return function;
+	}
+
 protected:
 	void init(const std::string &module_name, const std::string &function_name);
 	PyObject *function;
@@ -14,6 +14,17 @@ public:
 	std::vector<std::string> column_names(PyObject *args, PyObject *kwargs);
 	std::vector<duckdb::LogicalType> column_types(PyObject *args, PyObject *kwargs);
 
+	// Partition descriptors from the wrapper's partitions() method as a new list reference, or
+	// nullptr if the function isn't partitioned. Throws if the partitioner raises.
+	PyObject *partitions(PyObject *args, PyObject *kwargs);
+
+	// Number of rows the wrapper's estimated_rows() method expects a call to produce, or -1 if
+	// there is no estimate
+	int64_t estimated_rows(PyObject *args, PyObject *kwargs);
+
+	// True if the wrapper reports the function takes the named keyword argument
+	bool accepts_keyword(const std::string &name);
+
 private:
 	std::vector<PyObject *> pycolumn_types(PyObject *args, PyObject *kwargs);
 	std::vector<PyObject *> call_to_list(std::string attr_name, PyObject *args, PyObject *kwargs);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <duckdb.hpp>
+#include <string>
+
+namespace pyudf {
+// Calls a 'module:func' function in one of a pool of Python worker processes (see
+// ducktables/worker.py), once for each row of 'args' starting at 'first_column'. Argument and
+// result columns are exchanged through shared memory, and the worker converts results to the
+// type of 'result'. No Python runs in this process, so the GIL is neither needed nor taken.
+void CallInWorkerProcess(const std::string &function_specifier, duckdb::idx_t pool_size, duckdb::DataChunk &args,
+                         duckdb::idx_t first_column, duckdb::Vector &result);
+
+// The DuckDB type name a worker derives from the function's return annotation, or an empty
+// string if the function isn't annotated.
+std::string DescribeInWorkerProcess(const std::string &function_specifier, duckdb::idx_t pool_size);
+} // namespace pyudf
@@ -0,0 +1,95 @@
+#include <pyasync.hpp>
+
+using namespace duckdb;
+namespace pyudf {
+
+// Event loop plumbing, which is far easier to write in Python than through the C API
+static const char *ASYNC_HELPERS = R"(
+import asyncio
+
+async def _bounded(semaphore, function, args):
+    async with semaphore:
+        return await function(*args)
+
+def gather(loop, function, argument_tuples, concurrency):
+    async def run():
+        semaphore = asyncio.Semaphore(concurrency)
+        tasks = [asyncio.ensure_future(_bounded(semaphore, function, args)) for args in argument_tuples]
+        try:
+            return await asyncio.gather(*tasks)
+        except BaseException:
+            for task in tasks:
+                task.cancel()
+            await asyncio.gather(*tasks, return_exceptions=True)
+            raise
+    return loop.run_until_complete(run())
+
+def iterate(async_iterable):
+    loop = asyncio.new_event_loop()
+    iterator = async_iterable.__aiter__()
+    try:
+        while True:
+            try:
+                yield loop.run_until_complete(iterator.__anext__())
+            except StopAsyncIteration:
+                return
+    finally:
+        try:
+            aclose = getattr(iterator, 'aclose', None)
+            if aclose is not None:
+                loop.run_until_complete(aclose())
+        finally:
+            loop.close()
+)";
+
+// Borrowed reference to the helper module, compiled on first use
+static PyObject *AsyncHelpers() {
+	static PyObject *helpers = nullptr;
+	if (!helpers) {
+		PyObject *code = Py_CompileString(ASYNC_HELPERS, "<pytables_async>", Py_file_input);
+		if (!code) {
+			return nullptr;
+		}
+		helpers = PyImport_ExecCodeModule("_pytables_async", code);
+		Py_DECREF(code);
+	}
+	return helpers;
+}
+
+// Borrowed reference to this thread's event loop. Loops can't be entered from two threads at
+// once, so each of DuckDB's threads keeps one for the life of the process.
+static PyObject *ThreadEventLoop() {
+	thread_local PyObject *loop = nullptr;
+	if (!loop) {
+		PyObject *asyncio = PyImport_ImportModule("asyncio");
+		if (!asyncio) {
+			return nullptr;
+		}
+		loop = PyObject_CallMethod(asyncio, "new_event_loop", nullptr);
+		Py_DECREF(asyncio);
+	}
+	return loop;
+}
+
+PyObject *GatherAsync(PyObject *function, PyObject *argument_tuples, idx_t concurrency) {
+	PyObject *helpers = AsyncHelpers();
+	PyObject *loop = helpers ? ThreadEventLoop() : nullptr;
+	if (!loop) {
+		return nullptr;
+	}
+	// asyncio.gather() returns a list of the results in the order of the calls
+	return PyObject_CallMethod(helpers, "gather", "OOOn", loop, function, argument_tuples, (Py_ssize_t)concurrency);
+}
+
+bool IsAsyncIterable(PyObject *obj) {
+	return !PyIter_Check(obj) && PyObject_HasAttrString(obj, "__aiter__");
+}
+
+PyObject *IterateAsync(PyObject *async_iterable) {
+	PyObject *helpers = AsyncHelpers();
+	if (!helpers) {
+		return nullptr;
+	}
+	return PyObject_CallMethod(helpers, "iterate", "O", async_iterable);
+}
+} // namespace pyudf
@@ -1,15 +1,184 @@
 
 #include <pyconvert.hpp>
 #include <duckdb.hpp>
+#include <duckdb/common/types/date.hpp>
+#include <duckdb/common/types/decimal.hpp>
+#include <duckdb/common/types/hugeint.hpp>
+#include <duckdb/common/types/interval.hpp>
+#include <duckdb/common/types/time.hpp>
+#include <duckdb/common/types/timestamp.hpp>
+#include <duckdb/common/types/uuid.hpp>
 #include <Python.h>
+#include <cmath>
 #include <iostream>
 #include <unordered_map>
 #include <log.hpp>
 #include <cpy/module.hpp>
+#include <python_exception.hpp>
 
 namespace pyudf {
 
-PyObject *duckdb_to_py(duckdb::Value &value) {
+// New reference to a class from a module of the current interpreter, such as datetime.date
+static PyObject *PyModuleClass(const char *module_name, const char *class_name) {
+	// Borrowed references
+	PyObject *modules = PyImport_GetModuleDict();
+	PyObject *module = modules ? PyDict_GetItemString(modules, module_name) : nullptr;
+	if (module) {
+		return PyObject_GetAttrString(module, class_name);
+	}
+	module = PyImport_ImportModule(module_name);
+	if (!module) {
+		return nullptr;
+	}
+	PyObject *cls = PyObject_GetAttrString(module, class_name);
+	Py_DECREF(module);
+	return cls;
+}
+
+PyClasses::~PyClasses() {
+	for (auto cls : classes) {
+		Py_XDECREF(cls);
+	}
+}
+
+PyObject *PyClasses::Get(Class cls) {
+	if (classes[cls]) {
+		return classes[cls];
+	}
+	switch (cls) {
+	case DATE:
+		classes[cls] = PyModuleClass("datetime", "date");
+		break;
+	case TIME:
+		classes[cls] = PyModuleClass("datetime", "time");
+		break;
+	case DATETIME:
+		classes[cls] = PyModuleClass("datetime", "datetime");
+		break;
+	case UTC: {
+		PyObject *timezone = PyModuleClass("datetime", "timezone");
+		classes[cls] = timezone ? PyObject_GetAttrString(timezone, "utc") : nullptr;
+		Py_XDECREF(timezone);
+		break;
+	}
+	case DECIMAL:
+		classes[cls] = PyModuleClass("decimal", "Decimal");
+		break;
+	case UUID:
+		classes[cls] = PyModuleClass("uuid", "UUID");
+		break;
+	default:
+		throw std::runtime_error("Unknown Python class");
+	}
+	return classes[cls];
+}
+
+// Throws the pending Python error, for a class that can't be looked up or called
+static void ThrowPythonError() {
+	PythonException error;
+	throw std::runtime_error(error.message);
+}
+
+// Calls a class of the current interpreter. Values Python can't represent, such as dates past
+// the year 9999, raise OverflowError or ValueError and become None, any other error is thrown.
+static PyObject *PyConstruct(PyObject *cls, PyObject *args, PyObject *kwargs) {
+	PyObject *result = cls ? PyObject_Call(cls, args, kwargs) : nullptr;
+	Py_DECREF(args);
+	Py_XDECREF(kwargs);
+	if (result) {
+		return result;
+	} else if (cls && (PyErr_ExceptionMatches(PyExc_OverflowError) || PyErr_ExceptionMatches(PyExc_ValueError))) {
+		PyErr_Clear();
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	ThrowPythonError();
+	return nullptr;
+}
+
+static PyObject *DateToPy(duckdb::date_t date, PyClasses &classes) {
+	if (!duckdb::Date::IsFinite(date)) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	int32_t year, month, day;
+	duckdb::Date::Convert(date, year, month, day);
+	return PyConstruct(classes.Get(PyClasses::DATE), Py_BuildValue("(iii)", year, month, day), nullptr);
+}
+
+static PyObject *TimeToPy(duckdb::dtime_t time, PyClasses &classes) {
+	int32_t hour, minute, second, micros;
+	duckdb::Time::Convert(time, hour, minute, second, micros);
+	return PyConstruct(classes.Get(PyClasses::TIME), Py_BuildValue("(iiii)", hour, minute, second, micros), nullptr);
+}
+
+// Timestamps with time zone become datetimes in UTC
+static PyObject *TimestampToPy(duckdb::timestamp_t timestamp, bool utc, PyClasses &classes) {
+	if (!duckdb::Timestamp::IsFinite(timestamp)) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	duckdb::date_t date;
+	duckdb::dtime_t time;
+	duckdb::Timestamp::Convert(timestamp, date, time);
+	int32_t year, month, day, hour, minute, second, micros;
+	duckdb::Date::Convert(date, year, month, day);
+	duckdb::Time::Convert(time, hour, minute, second, micros);
+	PyObject *kwargs = nullptr;
+	if (utc) {
+		// Borrowed reference
+		PyObject *tz = classes.Get(PyClasses::UTC);
+		if (!tz) {
+			ThrowPythonError();
+		}
+		kwargs = PyDict_New();
+		PyDict_SetItemString(kwargs, "tzinfo", tz);
+	}
+	return PyConstruct(classes.Get(PyClasses::DATETIME),
+	                   Py_BuildValue("(iiiiiii)", year, month, day, hour, minute, second, micros), kwargs);
+}
+
+// decimal.Decimal built from its sign, digits and exponent, which keeps every digit exact
+static PyObject *DecimalToPy(duckdb::hugeint_t value, uint8_t scale, PyClasses &classes) {
+	bool negative = value < duckdb::hugeint_t(0);
+	auto magnitude = negative ? -value : value;
+	std::vector<long> digits;
+	do {
+		digits.push_back(duckdb::Hugeint::Cast<int64_t>(magnitude % duckdb::hugeint_t(10)));
+		magnitude = magnitude / duckdb::hugeint_t(10);
+	} while (magnitude > duckdb::hugeint_t(0));
+
+	PyObject *digits_tuple = PyTuple_New(digits.size());
+	for (idx_t i = 0; i < digits.size(); i++) {
+		PyTuple_SetItem(digits_tuple, i, PyLong_FromLong(digits[digits.size() - 1 - i]));
+	}
+	return PyConstruct(classes.Get(PyClasses::DECIMAL),
+	                   Py_BuildValue("((iNi))", negative ? 1 : 0, digits_tuple, -(int)scale), nullptr);
+}
+
+static PyObject *UUIDToPy(duckdb::hugeint_t value, PyClasses &classes) {
+	// DuckDB flips the top bit so that UUIDs sort like their string form
+	uint64_t upper = (uint64_t)value.upper ^ (uint64_t(1) << 63);
+	uint64_t lower = value.lower;
+	char bytes[16];
+	for (idx_t i = 0; i < 8; i++) {
+		bytes[i] = (char)(upper >> (56 - 8 * i));
+		bytes[8 + i] = (char)(lower >> (56 - 8 * i));
+	}
+	PyObject *kwargs = PyDict_New();
+	PyObject *py_bytes = PyBytes_FromStringAndSize(bytes, 16);
+	PyDict_SetItemString(kwargs, "bytes", py_bytes);
+	Py_DECREF(py_bytes);
+	return PyConstruct(classes.Get(PyClasses::UUID), PyTuple_New(0), kwargs);
+}
+
+static PyObject *StructToDict(duckdb::Value &value, PyClasses &classes);
+
+static PyObject *ValueToPy(duckdb::Value &value, PyClasses &classes) {
+	if (value.IsNull()) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
 	PyObject *py_value = nullptr;
 
 	switch (value.type().id()) {
@@ -38,7 +207,50 @@ PyObject *duckdb_to_py(duckdb::Value &value) {
 		py_value = PyUnicode_FromString(value.GetValue<std::string>().c_str());
 		break;
 	case duckdb::LogicalTypeId::STRUCT:
-		py_value = StructToDict(value);
+		py_value = StructToDict(value, classes);
+		break;
+	case duckdb::LogicalTypeId::DATE:
+		py_value = DateToPy(value.GetValue<duckdb::date_t>(), classes);
+		break;
+	case duckdb::LogicalTypeId::TIME:
+		py_value = TimeToPy(value.GetValue<duckdb::dtime_t>(), classes);
+		break;
+	case duckdb::LogicalTypeId::TIMESTAMP:
+		py_value = TimestampToPy(value.GetValue<duckdb::timestamp_t>(), false, classes);
+		break;
+	case duckdb::LogicalTypeId::TIMESTAMP_TZ:
+		py_value = TimestampToPy(value.GetValueUnsafe<duckdb::timestamp_t>(), true, classes);
+		break;
+	case duckdb::LogicalTypeId::TIMESTAMP_SEC:
+	case duckdb::LogicalTypeId::TIMESTAMP_MS:
+	case duckdb::LogicalTypeId::TIMESTAMP_NS:
+		py_value = TimestampToPy(value.DefaultCastAs(duckdb::LogicalType::TIMESTAMP).GetValue<duckdb::timestamp_t>(),
+		                         false, classes);
+		break;
+	case duckdb::LogicalTypeId::DECIMAL: {
+		auto scale = duckdb::DecimalType::GetScale(value.type());
+		switch (value.type().InternalType()) {
+		case duckdb::PhysicalType::INT16:
+			py_value = DecimalToPy(value.GetValueUnsafe<int16_t>(), scale, classes);
+			break;
+		case duckdb::PhysicalType::INT32:
+			py_value = DecimalToPy(value.GetValueUnsafe<int32_t>(), scale, classes);
+			break;
+		case duckdb::PhysicalType::INT64:
+			py_value = DecimalToPy(value.GetValueUnsafe<int64_t>(), scale, classes);
+			break;
+		default:
+			py_value = DecimalToPy(value.GetValueUnsafe<duckdb::hugeint_t>(), scale, classes);
+		}
+		break;
+	}
+	case duckdb::LogicalTypeId::BLOB: {
+		auto &blob = duckdb::StringValue::Get(value);
+		py_value = PyBytes_FromStringAndSize(blob.data(), blob.size());
+		break;
+	}
+	case duckdb::LogicalTypeId::UUID:
+		py_value = UUIDToPy(value.GetValueUnsafe<duckdb::hugeint_t>(), classes);
 		break;
 	default:
 		debug("Unhandled Logical Type: " + value.type().ToString());
@@ -48,19 +260,595 @@ PyObject *duckdb_to_py(duckdb::Value &value) {
 	return py_value;
 }
 
+PyObject *duckdb_to_py(duckdb::Value &value) {
+	PyClasses classes;
+	return ValueToPy(value, classes);
+}
+
 PyObject *duckdbs_to_pys(std::vector<duckdb::Value> &values) {
 	PyObject *py_tuple = PyTuple_New(values.size());
+	PyClasses classes;
 
 	for (size_t i = 0; i < values.size(); i++) {
 		PyObject *py_value = nullptr;
-		py_value = duckdb_to_py(values[i]);
+		py_value = ValueToPy(values[i], classes);
 		PyTuple_SetItem(py_tuple, i, py_value);
 	}
 
 	return py_tuple;
 }
 
-duckdb::Value ConvertPyObjectToDuckDBValue(PyObject *py_item, duckdb::LogicalType logical_type) {
+static PyObject *BoolToPy(bool value) {
+	return PyBool_FromLong(value);
+}
+
+template <class T>
+static PyObject *IntegerToPy(T value) {
+	return PyLong_FromLongLong((long long)value);
+}
+
+template <class T>
+static PyObject *UnsignedToPy(T value) {
+	return PyLong_FromUnsignedLongLong((unsigned long long)value);
+}
+
+template <class T>
+static PyObject *FloatToPy(T value) {
+	return PyFloat_FromDouble((double)value);
+}
+
+static PyObject *StringToPy(duckdb::string_t value) {
+	return PyUnicode_FromStringAndSize(value.GetData(), value.GetSize());
+}
+
+static PyObject *BlobToPy(duckdb::string_t value) {
+	return PyBytes_FromStringAndSize(value.GetData(), value.GetSize());
+}
+
+static PyObject *NaiveTimestampToPy(duckdb::timestamp_t value, PyClasses &classes) {
+	return TimestampToPy(value, false, classes);
+}
+
+static PyObject *UTCTimestampToPy(duckdb::timestamp_t value, PyClasses &classes) {
+	return TimestampToPy(value, true, classes);
+}
+
+// Reads a value of physical type T straight out of the vector's data and converts it with CONVERT
+template <class T, PyObject *(*CONVERT)(T)>
+static PyObject *ReadPyColumn(duckdb::Vector &vector, duckdb::UnifiedVectorFormat &format, PyClasses &classes,
+                              duckdb::idx_t row) {
+	auto idx = format.sel->get_index(row);
+	if (!format.validity.RowIsValid(idx)) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	return CONVERT(((T *)format.data)[idx]);
+}
+
+// Same as ReadPyColumn() for values that become instances of one of the chunk's classes
+template <class T, PyObject *(*CONVERT)(T, PyClasses &)>
+static PyObject *ReadPyClassColumn(duckdb::Vector &vector, duckdb::UnifiedVectorFormat &format, PyClasses &classes,
+                                   duckdb::idx_t row) {
+	auto idx = format.sel->get_index(row);
+	if (!format.validity.RowIsValid(idx)) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	return CONVERT(((T *)format.data)[idx], classes);
+}
+
+// T is the physical type of the DECIMAL
+template <class T>
+static PyObject *ReadPyDecimal(duckdb::Vector &vector, duckdb::UnifiedVectorFormat &format, PyClasses &classes,
+                               duckdb::idx_t row) {
+	auto idx = format.sel->get_index(row);
+	if (!format.validity.RowIsValid(idx)) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	return DecimalToPy(((T *)format.data)[idx], duckdb::DecimalType::GetScale(vector.GetType()), classes);
+}
+
+// Types without a specialized reader go through the generic Value conversion
+static PyObject *ReadPyValue(duckdb::Vector &vector, duckdb::UnifiedVectorFormat &format, PyClasses &classes,
+                             duckdb::idx_t row) {
+	auto value = vector.GetValue(row);
+	return ValueToPy(value, classes);
+}
+
+static py_column_reader_t GetDecimalReader(const duckdb::LogicalType &logical_type) {
+	switch (logical_type.InternalType()) {
+	case duckdb::PhysicalType::INT16:
+		return ReadPyDecimal<int16_t>;
+	case duckdb::PhysicalType::INT32:
+		return ReadPyDecimal<int32_t>;
+	case duckdb::PhysicalType::INT64:
+		return ReadPyDecimal<int64_t>;
+	default:
+		return ReadPyDecimal<duckdb::hugeint_t>;
+	}
+}
+
+py_column_reader_t GetColumnReader(const duckdb::LogicalType &logical_type) {
+	switch (logical_type.id()) {
+	case duckdb::LogicalTypeId::BOOLEAN:
+		return ReadPyColumn<bool, BoolToPy>;
+	case duckdb::LogicalTypeId::TINYINT:
+		return ReadPyColumn<int8_t, IntegerToPy<int8_t>>;
+	case duckdb::LogicalTypeId::SMALLINT:
+		return ReadPyColumn<int16_t, IntegerToPy<int16_t>>;
+	case duckdb::LogicalTypeId::INTEGER:
+		return ReadPyColumn<int32_t, IntegerToPy<int32_t>>;
+	case duckdb::LogicalTypeId::BIGINT:
+		return ReadPyColumn<int64_t, IntegerToPy<int64_t>>;
+	case duckdb::LogicalTypeId::UTINYINT:
+		return ReadPyColumn<uint8_t, UnsignedToPy<uint8_t>>;
+	case duckdb::LogicalTypeId::USMALLINT:
+		return ReadPyColumn<uint16_t, UnsignedToPy<uint16_t>>;
+	case duckdb::LogicalTypeId::UINTEGER:
+		return ReadPyColumn<uint32_t, UnsignedToPy<uint32_t>>;
+	case duckdb::LogicalTypeId::UBIGINT:
+		return ReadPyColumn<uint64_t, UnsignedToPy<uint64_t>>;
+	case duckdb::LogicalTypeId::FLOAT:
+		return ReadPyColumn<float, FloatToPy<float>>;
+	case duckdb::LogicalTypeId::DOUBLE:
+		return ReadPyColumn<double, FloatToPy<double>>;
+	case duckdb::LogicalTypeId::VARCHAR:
+		return ReadPyColumn<duckdb::string_t, StringToPy>;
+	case duckdb::LogicalTypeId::BLOB:
+		return ReadPyColumn<duckdb::string_t, BlobToPy>;
+	case duckdb::LogicalTypeId::DATE:
+		return ReadPyClassColumn<duckdb::date_t, DateToPy>;
+	case duckdb::LogicalTypeId::TIME:
+		return ReadPyClassColumn<duckdb::dtime_t, TimeToPy>;
+	case duckdb::LogicalTypeId::TIMESTAMP:
+		return ReadPyClassColumn<duckdb::timestamp_t, NaiveTimestampToPy>;
+	case duckdb::LogicalTypeId::TIMESTAMP_TZ:
+		return ReadPyClassColumn<duckdb::timestamp_t, UTCTimestampToPy>;
+	case duckdb::LogicalTypeId::DECIMAL:
+		return GetDecimalReader(logical_type);
+	case duckdb::LogicalTypeId::UUID:
+		return ReadPyClassColumn<duckdb::hugeint_t, UUIDToPy>;
+	default:
+		return ReadPyValue;
+	}
+}
+
+std::vector<py_column_reader_t> GetColumnReaders(const std::vector<duckdb::LogicalType> &logical_types) {
+	std::vector<py_column_reader_t> readers;
+	for (auto &logical_type : logical_types) {
+		readers.push_back(GetColumnReader(logical_type));
+	}
+	return readers;
+}
+
+PyRowReader::PyRowReader(const std::vector<py_column_reader_t> &readers, duckdb::DataChunk &chunk,
+                         duckdb::idx_t first_column)
+    : readers(readers), chunk(chunk), first_column(first_column), formats(readers.size()) {
+	D_ASSERT(first_column + readers.size() == chunk.ColumnCount());
+	for (idx_t i = 0; i < readers.size(); i++) {
+		chunk.data[first_column + i].ToUnifiedFormat(chunk.size(), formats[i]);
+	}
+}
+
+PyObject *PyRowReader::Row(duckdb::idx_t row) {
+	PyObject *py_tuple = PyTuple_New(readers.size());
+	try {
+		for (idx_t i = 0; i < readers.size(); i++) {
+			PyTuple_SetItem(py_tuple, i, readers[i](chunk.data[first_column + i], formats[i], classes, row));
+		}
+	} catch (...) {
+		Py_DECREF(py_tuple);
+		throw;
+	}
+	return py_tuple;
+}
+
+PyObject *VectorToPyList(duckdb::Vector &vector, duckdb::idx_t count) {
+	auto reader = GetColumnReader(vector.GetType());
+	duckdb::UnifiedVectorFormat format;
+	vector.ToUnifiedFormat(count, format);
+	PyClasses classes;
+
+	PyObject *py_list = PyList_New(count);
+	try {
+		for (idx_t row = 0; row < count; row++) {
+			PyList_SetItem(py_list, row, reader(vector, format, classes, row));
+		}
+	} catch (...) {
+		Py_DECREF(py_list);
+		throw;
+	}
+	return py_list;
+}
+
+// Not defined by the limited API prior to 3.11, though PyMemoryView_FromMemory() is
+#ifndef PyBUF_READ
+#define PyBUF_READ 0x100
+#endif
+
+// Format character of the memoryview handed to Python for a vector of the given type, or
+// nullptr if the type has no buffer representation.
+static const char *BufferFormat(const duckdb::LogicalType &type) {
+	switch (type.id()) {
+	case duckdb::LogicalTypeId::INTEGER:
+		return "i";
+	case duckdb::LogicalTypeId::BIGINT:
+		return "q";
+	case duckdb::LogicalTypeId::DOUBLE:
+		return "d";
+	default:
+		return nullptr;
+	}
+}
+
+static PyObject *TypedMemoryView(duckdb::data_ptr_t data, duckdb::idx_t size, const char *format) {
+	PyObject *bytes_view = PyMemoryView_FromMemory((char *)data, size, PyBUF_READ);
+	if (!bytes_view) {
+		return nullptr;
+	}
+	PyObject *typed_view = PyObject_CallMethod(bytes_view, "cast", "s", format);
+	Py_DECREF(bytes_view);
+	return typed_view;
+}
+
+PyObject *VectorToPyBuffer(duckdb::Vector &vector, duckdb::idx_t count) {
+	auto format = BufferFormat(vector.GetType());
+	if (!format) {
+		return nullptr;
+	}
+	vector.Flatten(count);
+
+	auto type_size = duckdb::GetTypeIdSize(vector.GetType().InternalType());
+	PyObject *data = TypedMemoryView(duckdb::FlatVector::GetData(vector), type_size * count, format);
+	if (!data) {
+		PythonException error;
+		throw std::runtime_error("Failed to create a memoryview of a vector: " + error.message);
+	}
+
+	// Validity is a bitmap of 64 bit words, bit (i % 64) of word (i / 64) is set when row i is not null
+	PyObject *validity;
+	auto &mask = duckdb::FlatVector::Validity(vector);
+	if (mask.AllValid()) {
+		Py_INCREF(Py_None);
+		validity = Py_None;
+	} else {
+		validity = TypedMemoryView((duckdb::data_ptr_t)mask.GetData(),
+		                           duckdb::ValidityMask::EntryCount(count) * sizeof(duckdb::validity_t), "Q");
+		if (!validity) {
+			Py_DECREF(data);
+			PythonException error;
+			throw std::runtime_error("Failed to create a memoryview of a validity mask: " + error.message);
+		}
+	}
+	PyObject *py_tuple = PyTuple_New(2);
+	PyTuple_SetItem(py_tuple, 0, data);
+	PyTuple_SetItem(py_tuple, 1, validity);
+	return py_tuple;
+}
+
+bool ReleasePyBuffer(PyObject *py_buffer) {
+	bool released = true;
+	for (Py_ssize_t i = 0; i < PyTuple_Size(py_buffer); i++) {
+		PyObject *view = PyTuple_GetItem(py_buffer, i);
+		if (Py_None == view) {
+			continue;
+		}
+		PyObject *result = PyObject_CallMethod(view, "release", nullptr);
+		if (result) {
+			Py_DECREF(result);
+		} else {
+			// Something still holds an export of the view (such as a numpy array)
+			PyErr_Clear();
+			released = false;
+		}
+	}
+	return released;
+}
+
+static long PyAttrAsLong(PyObject *py_object, const char *attr_name) {
+	PyObject *attr = PyObject_GetAttrString(py_object, attr_name);
+	if (!attr) {
+		PyErr_Clear();
+		return -1;
+	}
+	long value = PyLong_AsLong(attr);
+	Py_DECREF(attr);
+	return value;
+}
+
+static bool BufferFormatMatches(const std::string &format, const duckdb::LogicalType &type, long itemsize) {
+	// Strip any native byte order/alignment prefix, numpy reports these for some dtypes
+	auto code = format;
+	if (!code.empty() && (code[0] == '@' || code[0] == '=' || code[0] == '<')) {
+		code = code.substr(1);
+	}
+	if (code.size() != 1) {
+		return false;
+	}
+	auto type_size = (long)duckdb::GetTypeIdSize(type.InternalType());
+	if (itemsize != type_size) {
+		return false;
+	}
+	switch (type.id()) {
+	case duckdb::LogicalTypeId::INTEGER:
+	case duckdb::LogicalTypeId::BIGINT:
+		return std::string("bhilqn").find(code[0]) != std::string::npos;
+	case duckdb::LogicalTypeId::DOUBLE:
+		return code[0] == 'd';
+	default:
+		return false;
+	}
+}
+
+bool PyBufferToVector(PyObject *py_object, duckdb::Vector &result, duckdb::idx_t count) {
+	if (!BufferFormat(result.GetType()) || PyList_Check(py_object) || PyTuple_Check(py_object)) {
+		return false;
+	}
+	PyObject *view = PyMemoryView_FromObject(py_object);
+	if (!view) {
+		// Doesn't support the buffer protocol
+		PyErr_Clear();
+		return false;
+	}
+	cpy::Object view_obj(view, true);
+
+	auto format = view_obj.attr("format").str();
+	auto itemsize = PyAttrAsLong(view, "itemsize");
+	auto ndim = PyAttrAsLong(view, "ndim");
+	if (!BufferFormatMatches(format, result.GetType(), itemsize)) {
+		throw duckdb::InvalidInputException("Buffer of format '" + format + "' can not be used for a result of type " +
+		                                    result.GetType().ToString());
+	}
+	if (ndim != 1 || (duckdb::idx_t)PyObject_Size(view) != count) {
+		throw duckdb::InvalidInputException("Buffer result must be one dimensional with " + std::to_string(count) +
+		                                    " values");
+	}
+
+	// PyObject_GetBuffer() is not part of the limited ABI before 3.11, so we have the
+	// memoryview give us a contiguous copy of its contents and copy that into the vector.
+	PyObject *bytes = PyObject_CallMethod(view, "tobytes", nullptr);
+	if (!bytes) {
+		PythonException error;
+		throw std::runtime_error("Failed to read result buffer: " + error.message);
+	}
+	auto nbytes = itemsize * count;
+	if ((duckdb::idx_t)PyBytes_Size(bytes) != nbytes) {
+		Py_DECREF(bytes);
+		throw std::runtime_error("Result buffer has an unexpected size");
+	}
+	result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+	memcpy(duckdb::FlatVector::GetData(result), PyBytes_AsString(bytes), nbytes);
+	Py_DECREF(bytes);
+	return true;
+}
+
+// Reads integer attributes of an object, such as a date's year, month and day. Returns false
+// if any is missing or isn't an int. The datetime C API isn't part of the limited ABI, and
+// reading the fields keeps conversions to integer arithmetic instead of formatting strings.
+static bool PyIntAttrs(PyObject *py_object, const char *const *names, idx_t count, int64_t *values) {
+	for (idx_t i = 0; i < count; i++) {
+		PyObject *attr = PyObject_GetAttrString(py_object, names[i]);
+		if (!attr) {
+			PyErr_Clear();
+			return false;
+		}
+		bool is_int = PyLong_Check(attr);
+		values[i] = is_int ? PyLong_AsLongLong(attr) : 0;
+		Py_DECREF(attr);
+		if (!is_int) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// datetime.date (or datetime.datetime, whose time is dropped)
+static bool PyToDate(PyObject *py_item, duckdb::date_t &result) {
+	static const char *const fields[] = {"year", "month", "day"};
+	int64_t values[3];
+	return PyIntAttrs(py_item, fields, 3, values) &&
+	       duckdb::Date::TryFromDate((int32_t)values[0], (int32_t)values[1], (int32_t)values[2], result);
+}
+
+// datetime.time (or the time of a datetime.datetime)
+static bool PyToTime(PyObject *py_item, duckdb::dtime_t &result) {
+	static const char *const fields[] = {"hour", "minute", "second", "microsecond"};
+	int64_t values[4];
+	if (!PyIntAttrs(py_item, fields, 4, values)) {
+		return false;
+	}
+	result = duckdb::Time::FromTime((int32_t)values[0], (int32_t)values[1], (int32_t)values[2], (int32_t)values[3]);
+	return true;
+}
+
+// Microseconds a timezone aware datetime is ahead of UTC, 0 for naive ones
+static bool PyUTCOffset(PyObject *py_item, int64_t &micros) {
+	micros = 0;
+	PyObject *offset = PyObject_CallMethod(py_item, "utcoffset", nullptr);
+	if (!offset) {
+		PyErr_Clear();
+		return false;
+	}
+	static const char *const fields[] = {"days", "seconds", "microseconds"};
+	int64_t values[3] = {0, 0, 0};
+	bool valid = offset == Py_None || PyIntAttrs(offset, fields, 3, values);
+	Py_DECREF(offset);
+	micros = (values[0] * 86400 + values[1]) * duckdb::Interval::MICROS_PER_SEC + values[2];
+	return valid;
+}
+
+// datetime.datetime, in UTC if it is timezone aware. A datetime.date is taken as midnight.
+static bool PyToTimestamp(PyObject *py_item, duckdb::timestamp_t &result) {
+	duckdb::date_t date;
+	if (!PyToDate(py_item, date)) {
+		return false;
+	}
+	if (!PyObject_HasAttrString(py_item, "hour")) {
+		return duckdb::Timestamp::TryFromDatetime(date, duckdb::dtime_t(0), result);
+	}
+	duckdb::dtime_t time;
+	int64_t offset;
+	if (!PyToTime(py_item, time) || !PyUTCOffset(py_item, offset) ||
+	    !duckdb::Timestamp::TryFromDatetime(date, time, result)) {
+		return false;
+	}
+	result.value -= offset;
+	return true;
+}
+
+// Any int that fits 128 bits, from its low and high 64 bits. Python's '&' and '>>' work on the
+// two's complement of negative ints, which is also how hugeint_t stores them.
+static bool PyToHugeint(PyObject *py_item, duckdb::hugeint_t &result) {
+	auto value = PyLong_AsLongLong(py_item);
+	if (value != -1 || !PyErr_Occurred()) {
+		result = duckdb::hugeint_t(value);
+		return true;
+	}
+	PyErr_Clear();
+	PyObject *mask = PyLong_FromUnsignedLongLong(duckdb::NumericLimits<uint64_t>::Maximum());
+	PyObject *shift = PyLong_FromLong(64);
+	PyObject *lower = PyNumber_And(py_item, mask);
+	PyObject *upper = PyNumber_Rshift(py_item, shift);
+	bool valid = lower && upper;
+	if (valid) {
+		result.lower = PyLong_AsUnsignedLongLong(lower);
+		result.upper = PyLong_AsLongLong(upper);
+		valid = !PyErr_Occurred();
+	}
+	PyErr_Clear();
+	Py_XDECREF(upper);
+	Py_XDECREF(lower);
+	Py_DECREF(shift);
+	Py_DECREF(mask);
+	return valid;
+}
+
+// Sign, digits and exponent of a decimal.Decimal, read from its as_tuple()
+static bool PyDecimalDigits(PyObject *py_item, bool &negative, duckdb::hugeint_t &magnitude, int64_t &exponent) {
+	if (!PyObject_HasAttrString(py_item, "as_tuple")) {
+		return false;
+	}
+	PyObject *parts = PyObject_CallMethod(py_item, "as_tuple", nullptr);
+	if (!parts) {
+		PyErr_Clear();
+		return false;
+	}
+	// Borrowed references. The exponent is a string for NaN and infinities.
+	PyObject *sign = PyTuple_Check(parts) && PyTuple_Size(parts) == 3 ? PyTuple_GetItem(parts, 0) : nullptr;
+	PyObject *digits = sign ? PyTuple_GetItem(parts, 1) : nullptr;
+	PyObject *exp = sign ? PyTuple_GetItem(parts, 2) : nullptr;
+	bool valid = exp && PyLong_Check(exp) && PyTuple_Check(digits) &&
+	             PyTuple_Size(digits) <= duckdb::Decimal::MAX_WIDTH_DECIMAL;
+	if (valid) {
+		negative = PyLong_AsLong(sign) == 1;
+		exponent = PyLong_AsLongLong(exp);
+		magnitude = 0;
+		for (Py_ssize_t i = 0; i < PyTuple_Size(digits); i++) {
+			magnitude = magnitude * duckdb::hugeint_t(10) + duckdb::hugeint_t(PyLong_AsLong(PyTuple_GetItem(digits, i)));
+		}
+	}
+	Py_DECREF(parts);
+	return valid;
+}
+
+// decimal.Decimal, int or float scaled to a DECIMAL(width, scale)'s integer representation.
+// Decimals with more digits than the scale are rounded half away from zero like DuckDB's casts.
+static bool PyToDecimal(PyObject *py_item, uint8_t width, uint8_t scale, duckdb::hugeint_t &result) {
+	auto &powers = duckdb::Hugeint::POWERS_OF_TEN;
+	bool negative = false;
+	duckdb::hugeint_t magnitude;
+	int64_t exponent = 0;
+	if (PyBool_Check(py_item)) {
+		return false;
+	} else if (PyLong_Check(py_item)) {
+		duckdb::hugeint_t value;
+		if (!PyToHugeint(py_item, value) || value == duckdb::NumericLimits<duckdb::hugeint_t>::Minimum()) {
+			return false;
+		}
+		negative = value < duckdb::hugeint_t(0);
+		magnitude = negative ? -value : value;
+	} else if (PyFloat_Check(py_item)) {
+		auto scaled = std::round(PyFloat_AsDouble(py_item) * std::pow(10.0, scale));
+		if (!std::isfinite(scaled) || std::fabs(scaled) >= std::pow(10.0, width) ||
+		    !duckdb::Hugeint::TryConvert(scaled, result)) {
+			return false;
+		}
+		return true;
+	} else if (!PyDecimalDigits(py_item, negative, magnitude, exponent)) {
+		return false;
+	}
+
+	auto shift = exponent + scale;
+	if (shift >= 0) {
+		if (shift > width || magnitude >= powers[width - shift]) {
+			return false;
+		}
+		magnitude = magnitude * powers[shift];
+	} else if (-shift > duckdb::Decimal::MAX_WIDTH_DECIMAL) {
+		magnitude = 0;
+	} else {
+		auto &divisor = powers[-shift];
+		auto remainder = magnitude % divisor;
+		magnitude = magnitude / divisor;
+		if (remainder * duckdb::hugeint_t(2) >= divisor) {
+			magnitude = magnitude + duckdb::hugeint_t(1);
+		}
+	}
+	if (magnitude >= powers[width]) {
+		return false;
+	}
+	result = negative ? -magnitude : magnitude;
+	return true;
+}
+
+// bytes or bytearray, as a borrowed pointer into the object
+static bool PyToBlob(PyObject *py_item, char *&data, Py_ssize_t &size) {
+	if (PyBytes_Check(py_item)) {
+		return PyBytes_AsStringAndSize(py_item, &data, &size) == 0;
+	} else if (PyByteArray_Check(py_item)) {
+		data = PyByteArray_AsString(py_item);
+		size = PyByteArray_Size(py_item);
+		return data != nullptr;
+	}
+	return false;
+}
+
+// uuid.UUID, from the 16 big endian bytes of its 'bytes' attribute, or a UUID string
+static bool PyToUUID(PyObject *py_item, duckdb::hugeint_t &result) {
+	if (PyUnicode_Check(py_item)) {
+		PyObject *utf8 = PyUnicode_AsUTF8String(py_item);
+		if (!utf8) {
+			PyErr_Clear();
+			return false;
+		}
+		bool valid = duckdb::UUID::FromString(PyBytes_AsString(utf8), result);
+		Py_DECREF(utf8);
+		return valid;
+	}
+	PyObject *bytes = PyObject_GetAttrString(py_item, "bytes");
+	if (!bytes) {
+		PyErr_Clear();
+		return false;
+	}
+	bool valid = PyBytes_Check(bytes) && PyBytes_Size(bytes) == 16;
+	if (valid) {
+		auto data = (const uint8_t *)PyBytes_AsString(bytes);
+		uint64_t upper = 0;
+		uint64_t lower = 0;
+		for (idx_t i = 0; i < 8; i++) {
+			upper = (upper << 8) | data[i];
+			lower = (lower << 8) | data[8 + i];
+		}
+		// DuckDB flips the top bit so that UUIDs sort like their string form
+		result.upper = (int64_t)(upper ^ (uint64_t(1) << 63));
+		result.lower = lower;
+	}
+	Py_DECREF(bytes);
+	return valid;
+}
+
+duckdb::Value ConvertPyObjectToDuckDBValue(PyObject *py_item, const duckdb::LogicalType &logical_type) {
 	duckdb::Value value;
 	PyObject *py_value;
 	bool conversion_failed = false;
@@ -82,13 +870,19 @@ duckdb::Value ConvertPyObjectToDuckDBValue(PyObject *py_item, duckdb::LogicalTyp
 			value = duckdb::Value((int32_t)PyLong_AsLong(py_item));
 		}
 		break;
-	// case duckdb::LogicalTypeId::BIGINT:
-	//   if (!PyLong_Check(py_item)) {
-	//     conversion_failed = true;
-	//   } else {
-	//     value = duckdb::Value(PyLong_AsLongLong(py_item));
-	//   }
-	//   break;
+	case duckdb::LogicalTypeId::BIGINT:
+		if (!PyLong_Check(py_item)) {
+			conversion_failed = true;
+		} else {
+			auto big = PyLong_AsLongLong(py_item);
+			if (big == -1 && PyErr_Occurred()) {
+				PyErr_Clear();
+				conversion_failed = true;
+			} else {
+				value = duckdb::Value::BIGINT(big);
+			}
+		}
+		break;
 	case duckdb::LogicalTypeId::FLOAT:
 	case duckdb::LogicalTypeId::DOUBLE:
 		if (!PyFloat_Check(py_item)) {
@@ -106,6 +900,63 @@ duckdb::Value ConvertPyObjectToDuckDBValue(PyObject *py_item, duckdb::LogicalTyp
 			Py_DECREF(py_value);
 		}
 		break;
+	case duckdb::LogicalTypeId::DATE: {
+		duckdb::date_t date;
+		conversion_failed = !PyToDate(py_item, date);
+		if (!conversion_failed) {
+			value = duckdb::Value::DATE(date);
+		}
+		break;
+	}
+	case duckdb::LogicalTypeId::TIME: {
+		duckdb::dtime_t time;
+		conversion_failed = !PyToTime(py_item, time);
+		if (!conversion_failed) {
+			value = duckdb::Value::TIME(time);
+		}
+		break;
+	}
+	case duckdb::LogicalTypeId::TIMESTAMP:
+	case duckdb::LogicalTypeId::TIMESTAMP_TZ: {
+		duckdb::timestamp_t timestamp;
+		conversion_failed = !PyToTimestamp(py_item, timestamp);
+		if (!conversion_failed) {
+			value = logical_type.id() == duckdb::LogicalTypeId::TIMESTAMP ? duckdb::Value::TIMESTAMP(timestamp)
+			                                                              : duckdb::Value::TIMESTAMPTZ(timestamp);
+		}
+		break;
+	}
+	case duckdb::LogicalTypeId::DECIMAL: {
+		auto width = duckdb::DecimalType::GetWidth(logical_type);
+		auto scale = duckdb::DecimalType::GetScale(logical_type);
+		duckdb::hugeint_t decimal;
+		conversion_failed = !PyToDecimal(py_item, width, scale, decimal);
+		if (conversion_failed) {
+			break;
+		} else if (width <= duckdb::Decimal::MAX_WIDTH_INT64) {
+			value = duckdb::Value::DECIMAL(duckdb::Hugeint::Cast<int64_t>(decimal), width, scale);
+		} else {
+			value = duckdb::Value::DECIMAL(decimal, width, scale);
+		}
+		break;
+	}
+	case duckdb::LogicalTypeId::BLOB: {
+		char *data;
+		Py_ssize_t size;
+		conversion_failed = !PyToBlob(py_item, data, size);
+		if (!conversion_failed) {
+			value = duckdb::Value::BLOB((duckdb::const_data_ptr_t)data, size);
+		}
+		break;
+	}
+	case duckdb::LogicalTypeId::UUID: {
+		duckdb::hugeint_t uuid;
+		conversion_failed = !PyToUUID(py_item, uuid);
+		if (!conversion_failed) {
+			value = duckdb::Value::UUID(uuid);
+		}
+		break;
+	}
 		// Add more cases for other LogicalTypes here
 	case duckdb::LogicalTypeId::STRUCT:
 		py_value = StructToDict(value);
@@ -121,8 +972,235 @@ duckdb::Value ConvertPyObjectToDuckDBValue(PyObject *py_item, duckdb::LogicalTyp
 	return value;
 }
 
-void ConvertPyObjectsToDuckDBValues(PyObject *py_iterator, std::vector<duckdb::LogicalType> logical_types,
-                                    std::vector<duckdb::Value> &result) {
+static void WriteNull(duckdb::Vector &vector, duckdb::idx_t row) {
+	duckdb::FlatVector::SetNull(vector, row, true);
+}
+
+// The writers below check for the exact Python type first, which is what functions return
+// almost every time, and only then fall back to a slower coercion of other objects.
+
+// Integers that aren't exact ints: bools and other int subclasses, objects with __index__ such
+// as numpy integers, and floats without a fractional part
+static bool PyCoerceLong(PyObject *py_item, long long &value) {
+	if (py_item == Py_None) {
+		return false;
+	}
+	if (PyFloat_Check(py_item)) {
+		double number = PyFloat_AsDouble(py_item);
+		if (!(number >= -9223372036854775808.0 && number < 9223372036854775808.0) || number != std::trunc(number)) {
+			return false;
+		}
+		value = (long long)number;
+		return true;
+	}
+	PyObject *index = PyNumber_Index(py_item);
+	if (!index) {
+		PyErr_Clear();
+		return false;
+	}
+	value = PyLong_AsLongLong(index);
+	Py_DECREF(index);
+	if (value == -1 && PyErr_Occurred()) {
+		// Doesn't fit in 64 bits
+		PyErr_Clear();
+		return false;
+	}
+	return true;
+}
+
+// Numbers that aren't exact floats, such as ints, Decimals and numpy floats. Strings and bytes
+// aren't parsed even though float() would accept them.
+static bool PyCoerceDouble(PyObject *py_item, double &value) {
+	if (py_item == Py_None || PyUnicode_Check(py_item) || PyBytes_Check(py_item) || PyByteArray_Check(py_item)) {
+		return false;
+	}
+	PyObject *number = PyNumber_Float(py_item);
+	if (!number) {
+		PyErr_Clear();
+		return false;
+	}
+	value = PyFloat_AsDouble(number);
+	Py_DECREF(number);
+	return true;
+}
+
+static void WritePyBool(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	if (py_item == Py_True || py_item == Py_False) {
+		duckdb::FlatVector::GetData<bool>(vector)[row] = (Py_True == py_item);
+		return;
+	}
+	WriteNull(vector, row);
+}
+
+template <class T>
+static void WritePyLong(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	long long value;
+	if (PyLong_CheckExact(py_item)) {
+		value = PyLong_AsLongLong(py_item);
+		if (value == -1 && PyErr_Occurred()) {
+			// Doesn't fit in 64 bits
+			PyErr_Clear();
+			WriteNull(vector, row);
+			return;
+		}
+	} else if (!PyCoerceLong(py_item, value)) {
+		WriteNull(vector, row);
+		return;
+	}
+	if (value < duckdb::NumericLimits<T>::Minimum() || value > duckdb::NumericLimits<T>::Maximum()) {
+		WriteNull(vector, row);
+		return;
+	}
+	duckdb::FlatVector::GetData<T>(vector)[row] = (T)value;
+}
+
+template <class T>
+static void WritePyFloat(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	double value;
+	if (PyFloat_CheckExact(py_item)) {
+		value = PyFloat_AsDouble(py_item);
+	} else if (!PyCoerceDouble(py_item, value)) {
+		WriteNull(vector, row);
+		return;
+	}
+	duckdb::FlatVector::GetData<T>(vector)[row] = (T)value;
+}
+
+static void WritePyUnicode(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	// Includes str subclasses, such as str based enums
+	if (!PyUnicode_Check(py_item)) {
+		WriteNull(vector, row);
+		return;
+	}
+	PyObject *utf8 = PyUnicode_AsUTF8String(py_item);
+	if (!utf8) {
+		// Such as strings containing lone surrogates
+		PyErr_Clear();
+		WriteNull(vector, row);
+		return;
+	}
+	char *buffer;
+	Py_ssize_t length;
+	PyBytes_AsStringAndSize(utf8, &buffer, &length);
+	duckdb::FlatVector::GetData<duckdb::string_t>(vector)[row] = duckdb::StringVector::AddString(vector, buffer, length);
+	Py_DECREF(utf8);
+}
+
+static void WritePyDate(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	if (!PyToDate(py_item, duckdb::FlatVector::GetData<duckdb::date_t>(vector)[row])) {
+		WriteNull(vector, row);
+	}
+}
+
+static void WritePyTime(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	if (!PyToTime(py_item, duckdb::FlatVector::GetData<duckdb::dtime_t>(vector)[row])) {
+		WriteNull(vector, row);
+	}
+}
+
+static void WritePyTimestamp(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	if (!PyToTimestamp(py_item, duckdb::FlatVector::GetData<duckdb::timestamp_t>(vector)[row])) {
+		WriteNull(vector, row);
+	}
+}
+
+// T is the physical type of the DECIMAL, which the width was already checked to fit
+template <class T>
+static void WritePyDecimal(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	auto &type = vector.GetType();
+	duckdb::hugeint_t value;
+	if (!PyToDecimal(py_item, duckdb::DecimalType::GetWidth(type), duckdb::DecimalType::GetScale(type), value)) {
+		WriteNull(vector, row);
+		return;
+	}
+	duckdb::FlatVector::GetData<T>(vector)[row] = duckdb::Hugeint::Cast<T>(value);
+}
+
+static void WritePyBlob(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	char *data;
+	Py_ssize_t size;
+	if (!PyToBlob(py_item, data, size)) {
+		WriteNull(vector, row);
+		return;
+	}
+	duckdb::FlatVector::GetData<duckdb::string_t>(vector)[row] = duckdb::StringVector::AddStringOrBlob(vector, data, size);
+}
+
+static void WritePyUUID(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	if (!PyToUUID(py_item, duckdb::FlatVector::GetData<duckdb::hugeint_t>(vector)[row])) {
+		WriteNull(vector, row);
+	}
+}
+
+static py_column_writer_t GetDecimalWriter(const duckdb::LogicalType &logical_type) {
+	switch (logical_type.InternalType()) {
+	case duckdb::PhysicalType::INT16:
+		return WritePyDecimal<int16_t>;
+	case duckdb::PhysicalType::INT32:
+		return WritePyDecimal<int32_t>;
+	case duckdb::PhysicalType::INT64:
+		return WritePyDecimal<int64_t>;
+	default:
+		return WritePyDecimal<duckdb::hugeint_t>;
+	}
+}
+
+// Types without a specialized writer go through the generic Value conversion
+static void WritePyValue(PyObject *py_item, duckdb::Vector &vector, duckdb::idx_t row) {
+	vector.SetValue(row, ConvertPyObjectToDuckDBValue(py_item, vector.GetType()));
+}
+
+py_column_writer_t GetColumnWriter(const duckdb::LogicalType &logical_type) {
+	switch (logical_type.id()) {
+	case duckdb::LogicalTypeId::BOOLEAN:
+		return WritePyBool;
+	case duckdb::LogicalTypeId::TINYINT:
+		return WritePyLong<int8_t>;
+	case duckdb::LogicalTypeId::SMALLINT:
+		return WritePyLong<int16_t>;
+	case duckdb::LogicalTypeId::INTEGER:
+		return WritePyLong<int32_t>;
+	case duckdb::LogicalTypeId::BIGINT:
+		return WritePyLong<int64_t>;
+	case duckdb::LogicalTypeId::FLOAT:
+		return WritePyFloat<float>;
+	case duckdb::LogicalTypeId::DOUBLE:
+		return WritePyFloat<double>;
+	case duckdb::LogicalTypeId::VARCHAR:
+		return WritePyUnicode;
+	case duckdb::LogicalTypeId::DATE:
+		return WritePyDate;
+	case duckdb::LogicalTypeId::TIME:
+		return WritePyTime;
+	case duckdb::LogicalTypeId::TIMESTAMP:
+	case duckdb::LogicalTypeId::TIMESTAMP_TZ:
+		return WritePyTimestamp;
+	case duckdb::LogicalTypeId::DECIMAL:
+		return GetDecimalWriter(logical_type);
+	case duckdb::LogicalTypeId::BLOB:
+		return WritePyBlob;
+	case duckdb::LogicalTypeId::UUID:
+		return WritePyUUID;
+	default:
+		return WritePyValue;
+	}
+}
+
+std::vector<py_column_writer_t> GetColumnWriters(const std::vector<duckdb::LogicalType> &logical_types) {
+	std::vector<py_column_writer_t> writers;
+	for (auto &logical_type : logical_types) {
+		writers.push_back(GetColumnWriter(logical_type));
+	}
+	return writers;
+}
+
+static duckdb::InvalidInputException RowWidthError(size_t width, size_t expected) {
+	return duckdb::InvalidInputException("A row with " + std::to_string(width) + " values was detected though " +
+	                                     std::to_string(expected) + " columns were expected");
+}
+
+void WritePyRow(PyObject *py_iterator, const std::vector<py_column_writer_t> &writers,
+                const std::vector<duckdb::idx_t> &output_columns, duckdb::DataChunk &output, duckdb::idx_t row) {
 
 	if (!PyIter_Check(py_iterator)) {
 		throw duckdb::InvalidInputException("First argument must be an iterator");
@@ -132,16 +1210,13 @@ void ConvertPyObjectsToDuckDBValues(PyObject *py_iterator, std::vector<duckdb::L
 	size_t index = 0;
 	std::string error_message;
 	while ((py_item = PyIter_Next(py_iterator))) {
-		if (index >= logical_types.size()) {
+		if (index >= writers.size()) {
 			Py_DECREF(py_item);
-			error_message = "A row with " + std::to_string(index + 1) + " values was detected though " +
-			                std::to_string(logical_types.size()) + " columns were expected",
-			throw duckdb::InvalidInputException(error_message);
+			throw RowWidthError(index + 1, writers.size());
+		}
+		if (writers[index]) {
+			writers[index](py_item, output.data[output_columns[index]], row);
 		}
-		duckdb::LogicalType logical_type = logical_types[index];
-
-		duckdb::Value value = ConvertPyObjectToDuckDBValue(py_item, logical_type);
-		result.push_back(value);
 		Py_DECREF(py_item);
 		index++;
 	}
@@ -153,16 +1228,256 @@ void ConvertPyObjectsToDuckDBValues(PyObject *py_iterator, std::vector<duckdb::L
 		throw std::runtime_error(error_message);
 	}
 
-	if (index != logical_types.size()) {
-		error_message = "A row with " + std::to_string(index) + " values was detected though " +
-		                std::to_string(logical_types.size()) + " columns were expected";
-		throw duckdb::InvalidInputException(error_message);
+	if (index != writers.size()) {
+		throw RowWidthError(index, writers.size());
 	}
 }
 
+void PyRowKeys::Append(const std::string &name) {
+	names.push_back(PyUnicode_InternFromString(name.c_str()));
+}
+
+void PyRowKeys::Release() {
+	for (auto name : names) {
+		Py_XDECREF(name);
+	}
+	names.clear();
+	Py_XDECREF(row_type);
+	row_type = nullptr;
+}
+
+// Whether every column name is one of a NamedTuple type's '_fields'
+static bool HasAllFields(PyObject *type, const std::vector<PyObject *> &names) {
+	PyObject *fields = PyObject_GetAttrString(type, "_fields");
+	if (!fields) {
+		PyErr_Clear();
+		return false;
+	}
+	bool has_all = true;
+	for (auto name : names) {
+		int contains = PySequence_Contains(fields, name);
+		if (contains != 1) {
+			if (contains < 0) {
+				PyErr_Clear();
+			}
+			has_all = false;
+			break;
+		}
+	}
+	Py_DECREF(fields);
+	return has_all;
+}
+
+static PyRowKind GetRowKind(PyObject *py_row, const PyRowKeys &keys) {
+	if (PyTuple_CheckExact(py_row) || PyList_CheckExact(py_row)) {
+		return PyRowKind::SEQUENCE;
+	} else if (PyDict_Check(py_row)) {
+		return PyRowKind::MAPPING;
+	}
+	auto type = (PyObject *)Py_TYPE(py_row);
+	if (PyTuple_Check(py_row)) {
+		// NamedTuples are read by name only when their fields are the columns, since columns
+		// may well be named differently (explicit 'columns', renamed fields, ...)
+		if (PyObject_HasAttrString(type, "_fields") && HasAllFields(type, keys.names)) {
+			return PyRowKind::ATTRIBUTES;
+		}
+		return PyRowKind::SEQUENCE;
+	}
+	if (PyObject_HasAttrString(type, "__dataclass_fields__")) {
+		return PyRowKind::ATTRIBUTES;
+	}
+	return PyRowKind::ITERABLE;
+}
+
+template <PyObject *(*GET_ITEM)(PyObject *, Py_ssize_t)>
+static void WriteSequenceRow(PyObject *py_row, Py_ssize_t width, const std::vector<py_column_writer_t> &writers,
+                             const std::vector<duckdb::idx_t> &output_columns, duckdb::DataChunk &output,
+                             duckdb::idx_t row) {
+	if ((size_t)width != writers.size()) {
+		throw RowWidthError(width, writers.size());
+	}
+	for (idx_t index = 0; index < writers.size(); index++) {
+		if (writers[index]) {
+			// Borrowed reference
+			writers[index](GET_ITEM(py_row, index), output.data[output_columns[index]], row);
+		}
+	}
+}
+
+void WritePyRowObject(PyObject *py_row, const std::vector<py_column_writer_t> &writers,
+                      const std::vector<duckdb::idx_t> &output_columns, PyRowKeys &keys,
+                      duckdb::DataChunk &output, duckdb::idx_t row) {
+	if (PyTuple_CheckExact(py_row)) {
+		WriteSequenceRow<PyTuple_GetItem>(py_row, PyTuple_Size(py_row), writers, output_columns, output, row);
+		return;
+	} else if (PyList_CheckExact(py_row)) {
+		WriteSequenceRow<PyList_GetItem>(py_row, PyList_Size(py_row), writers, output_columns, output, row);
+		return;
+	}
+
+	auto type = (PyObject *)Py_TYPE(py_row);
+	if (type != keys.row_type) {
+		Py_INCREF(type);
+		Py_XDECREF(keys.row_type);
+		keys.row_type = type;
+		keys.row_kind = GetRowKind(py_row, keys);
+	}
+	if (keys.row_kind == PyRowKind::SEQUENCE) {
+		// Tuple subclasses, such as NamedTuples whose fields aren't the columns
+		WriteSequenceRow<PyTuple_GetItem>(py_row, PyTuple_Size(py_row), writers, output_columns, output, row);
+		return;
+	}
+	if (keys.row_kind == PyRowKind::MAPPING || keys.row_kind == PyRowKind::ATTRIBUTES) {
+		D_ASSERT(keys.names.size() == writers.size());
+		for (idx_t index = 0; index < writers.size(); index++) {
+			if (!writers[index]) {
+				continue;
+			}
+			auto &vector = output.data[output_columns[index]];
+			if (keys.row_kind == PyRowKind::MAPPING) {
+				// Borrowed reference, null without an exception if the key is missing
+				PyObject *py_item = PyDict_GetItem(py_row, keys.names[index]);
+				writers[index](py_item ? py_item : Py_None, vector, row);
+				continue;
+			}
+			PyObject *py_item = PyObject_GetAttr(py_row, keys.names[index]);
+			if (!py_item) {
+				PythonException error;
+				throw duckdb::InvalidInputException("A row lacks the attribute of one of the columns: " +
+				                                    error.message);
+			}
+			writers[index](py_item, vector, row);
+			Py_DECREF(py_item);
+		}
+		return;
+	}
+
+	PyObject *py_iterator = pyObjectToIterable(py_row);
+	try {
+		WritePyRow(py_iterator, writers, output_columns, output, row);
+	} catch (...) {
+		Py_DECREF(py_iterator);
+		throw;
+	}
+	Py_DECREF(py_iterator);
+}
+
+// One column of a batch: its values as an exact list or tuple, and how to read them by index
+struct PyBatchColumn {
+	PyObject *values = nullptr;
+	PyObject *(*get_item)(PyObject *, Py_ssize_t) = nullptr;
+	idx_t size = 0;
+};
+
+static void ReleaseBatchColumns(std::vector<PyBatchColumn> &columns) {
+	for (auto &column : columns) {
+		Py_XDECREF(column.values);
+	}
+}
+
+static bool PyBatchColumnValues(PyObject *py_column, PyBatchColumn &column) {
+	if (PyList_CheckExact(py_column)) {
+		Py_INCREF(py_column);
+		column.values = py_column;
+	} else if (PyTuple_CheckExact(py_column)) {
+		Py_INCREF(py_column);
+		column.values = py_column;
+		column.get_item = PyTuple_GetItem;
+		column.size = PyTuple_Size(py_column);
+		return true;
+	} else {
+		// Any other sequence or iterable, such as a range or a numpy array
+		column.values = PySequence_List(py_column);
+		if (!column.values) {
+			return false;
+		}
+	}
+	column.get_item = PyList_GetItem;
+	column.size = PyList_Size(column.values);
+	return true;
+}
+
+idx_t WritePyBatch(PyObject *py_batch, const std::vector<py_column_writer_t> &writers,
+                   const std::vector<duckdb::idx_t> &output_columns, PyRowKeys &keys, duckdb::DataChunk &output) {
+	std::vector<PyBatchColumn> columns(writers.size());
+	bool by_name = PyDict_Check(py_batch);
+	PyObject *py_columns = nullptr;
+	if (!by_name) {
+		py_columns = PySequence_Tuple(py_batch);
+		if (!py_columns) {
+			PyErr_Clear();
+			throw duckdb::InvalidInputException("A batch must be a tuple of columns or a dict of columns by name");
+		}
+		if ((size_t)PyTuple_Size(py_columns) != writers.size()) {
+			auto width = PyTuple_Size(py_columns);
+			Py_DECREF(py_columns);
+			throw duckdb::InvalidInputException("A batch with " + std::to_string(width) +
+			                                    " columns was detected though " + std::to_string(writers.size()) +
+			                                    " columns were expected");
+		}
+	}
+
+	idx_t count = 0;
+	bool any_column = false;
+	for (idx_t index = 0; index < writers.size(); index++) {
+		// Borrowed references. Columns missing from a dict are all nulls.
+		PyObject *py_column =
+		    by_name ? PyDict_GetItem(py_batch, keys.names[index]) : PyTuple_GetItem(py_columns, index);
+		if (!py_column) {
+			continue;
+		}
+		if (!PyBatchColumnValues(py_column, columns[index])) {
+			PyErr_Clear();
+			ReleaseBatchColumns(columns);
+			Py_XDECREF(py_columns);
+			throw duckdb::InvalidInputException("Column " + std::to_string(index + 1) + " of a batch isn't a sequence");
+		}
+		if (any_column && columns[index].size != count) {
+			ReleaseBatchColumns(columns);
+			Py_XDECREF(py_columns);
+			throw duckdb::InvalidInputException("The columns of a batch must all have the same length, found " +
+			                                    std::to_string(count) + " and " +
+			                                    std::to_string(columns[index].size) + " values");
+		}
+		count = columns[index].size;
+		any_column = true;
+	}
+	Py_XDECREF(py_columns);
+	if (!any_column) {
+		throw duckdb::InvalidInputException("A batch has none of the expected columns");
+	}
+	if (output.size() + count > STANDARD_VECTOR_SIZE) {
+		ReleaseBatchColumns(columns);
+		throw duckdb::InvalidInputException("A batch of " + std::to_string(count) +
+		                                    " rows was detected, batches hold at most " +
+		                                    std::to_string(STANDARD_VECTOR_SIZE) + " rows");
+	}
+
+	// Column by column, each writer runs over a whole column at once
+	auto offset = output.size();
+	try {
+		for (idx_t index = 0; index < writers.size(); index++) {
+			if (!writers[index]) {
+				continue;
+			}
+			auto &vector = output.data[output_columns[index]];
+			auto &column = columns[index];
+			for (idx_t row = 0; row < count; row++) {
+				writers[index](column.values ? column.get_item(column.values, row) : Py_None, vector, offset + row);
+			}
+		}
+	} catch (...) {
+		ReleaseBatchColumns(columns);
+		throw;
+	}
+	ReleaseBatchColumns(columns);
+	return count;
+}
+
 PyObject *pyObjectToIterable(PyObject *py_object) {
+	// Looked up once, pytable functions only run in the main interpreter
+	static PyObject *iterable_class = cpy::Module("collections.abc").attr("Iterable").getpy();
 	cpy::Object obj(py_object);
-	cpy::Object iterable_class = cpy::Module("collections.abc").attr("Iterable");
 	if (!obj.isinstance(iterable_class)) {
 		throw std::runtime_error("Object is not an iterable, presumably...");
 	}
@@ -171,6 +1486,11 @@ PyObject *pyObjectToIterable(PyObject *py_object) {
 }
 
 PyObject *StructToDict(duckdb::Value value) {
+	PyClasses classes;
+	return StructToDict(value, classes);
+}
+
+static PyObject *StructToDict(duckdb::Value &value, PyClasses &classes) {
 	// Build the keyword argument dictionary
 	PyObject *py_value = PyDict_New();
 	auto &child_type = value.type();
@@ -180,8 +1500,8 @@ PyObject *StructToDict(duckdb::Value value) {
 		duckdb::Value name = duckdb::StructType::GetChildName(child_type, i);
 		duckdb::Value val = struct_children[i];
 
-		auto pyName = duckdb_to_py(name);
-		auto pyValue = duckdb_to_py(val);
+		auto pyName = ValueToPy(name, classes);
+		auto pyValue = ValueToPy(val, classes);
 		PyDict_SetItem(py_value, pyName, pyValue);
 	}
 	return py_value;
@@ -195,6 +1515,12 @@ std::vector<duckdb::LogicalType> PyTypesToLogicalTypes(const std::vector<PyObjec
 	    {"int", duckdb::LogicalType::INTEGER},
 	    {"str", duckdb::LogicalType::VARCHAR},
 	    {"float", duckdb::LogicalType::DOUBLE},
+	    {"bool", duckdb::LogicalType::BOOLEAN},
+	    {"bytes", duckdb::LogicalType::BLOB},
+	    {"date", duckdb::LogicalType::DATE},
+	    {"time", duckdb::LogicalType::TIME},
+	    {"datetime", duckdb::LogicalType::TIMESTAMP},
+	    {"UUID", duckdb::LogicalType::UUID},
 	    // TODO: Add more mappings for other supported Python types
 	};
 
@@ -206,6 +1532,14 @@ std::vector<duckdb::LogicalType> PyTypesToLogicalTypes(const std::vector<PyObjec
 			if (typeNameObj && PyUnicode_Check(typeNameObj)) {
 				const char *typeName = Unicode_AsUTF8(typeNameObj);
 
+				if (typeName && std::string(typeName) == "Decimal") {
+					// Any width and scale picked here would round or drop some Decimals
+					Py_DECREF(typeNameObj);
+					throw duckdb::InvalidInputException(
+					    "A decimal.Decimal annotation doesn't say how many digits to keep, declare the type as a "
+					    "DuckDB type name such as 'DECIMAL(18,3)' instead");
+				}
+
 				// Find the corresponding DuckDB logical type
 				auto it = typeMap.find(typeName);
 				if (it != typeMap.end()) {
@@ -0,0 +1,521 @@
+#include <pydataframe.hpp>
+#include <duckdb.hpp>
+#include <duckdb/common/types/interval.hpp>
+#include <Python.h>
+#include <pyconvert.hpp>
+#include <python_exception.hpp>
+
+using namespace duckdb;
+namespace pyudf {
+
+// Constants of the dataframe interchange protocol
+enum PyDtypeKind : int64_t {
+	DTYPE_INT = 0,
+	DTYPE_UINT = 1,
+	DTYPE_FLOAT = 2,
+	DTYPE_BOOL = 20,
+	DTYPE_STRING = 21,
+	DTYPE_DATETIME = 22
+};
+enum PyNullKind : int64_t { NULL_NONE = 0, NULL_NAN = 1, NULL_SENTINEL = 2, NULL_BITMASK = 3, NULL_BYTEMASK = 4 };
+
+bool IsPyDataFrame(PyObject *py_object) {
+	return PyObject_HasAttrString(py_object, "__dataframe__");
+}
+
+static InvalidInputException DataFrameError(const std::string &message) {
+	PythonException error;
+	return InvalidInputException(message + ": " + error.message);
+}
+
+// Integer item of a tuple, or 'fallback' for None
+static int64_t PyTupleLong(PyObject *py_tuple, Py_ssize_t index, int64_t fallback = 0) {
+	// Borrowed reference
+	PyObject *item = PyTuple_GetItem(py_tuple, index);
+	if (!item || item == Py_None) {
+		PyErr_Clear();
+		return fallback;
+	}
+	auto value = PyLong_AsLongLong(item);
+	if (value == -1 && PyErr_Occurred()) {
+		PyErr_Clear();
+		return fallback;
+	}
+	return value;
+}
+
+// str() of an object, empty if that fails
+static std::string PyToString(PyObject *py_object) {
+	PyObject *py_str = PyObject_Str(py_object);
+	PyObject *utf8 = py_str ? PyUnicode_AsUTF8String(py_str) : nullptr;
+	Py_XDECREF(py_str);
+	if (!utf8) {
+		PyErr_Clear();
+		return std::string();
+	}
+	std::string result(PyBytes_AsString(utf8), PyBytes_Size(utf8));
+	Py_DECREF(utf8);
+	return result;
+}
+
+static int64_t PyMethodLong(PyObject *py_object, const char *name, int64_t fallback) {
+	PyObject *result = PyObject_CallMethod(py_object, name, nullptr);
+	if (!result) {
+		PyErr_Clear();
+		return fallback;
+	}
+	auto value = result == Py_None ? fallback : PyLong_AsLongLong(result);
+	Py_DECREF(result);
+	if (PyErr_Occurred()) {
+		PyErr_Clear();
+		return fallback;
+	}
+	return value;
+}
+
+// DuckDB type of a column read through its buffers, INVALID for dtypes that aren't
+static LogicalType BufferColumnType(PyDataFrameColumn &column, const std::string &format) {
+	switch (column.kind) {
+	case DTYPE_INT:
+		switch (column.bit_width) {
+		case 8:
+			return LogicalType::TINYINT;
+		case 16:
+			return LogicalType::SMALLINT;
+		case 32:
+			return LogicalType::INTEGER;
+		case 64:
+			return LogicalType::BIGINT;
+		}
+		break;
+	case DTYPE_UINT:
+		switch (column.bit_width) {
+		case 8:
+			return LogicalType::UTINYINT;
+		case 16:
+			return LogicalType::USMALLINT;
+		case 32:
+			return LogicalType::UINTEGER;
+		case 64:
+			return LogicalType::UBIGINT;
+		}
+		break;
+	case DTYPE_FLOAT:
+		if (column.bit_width == 32) {
+			return LogicalType::FLOAT;
+		} else if (column.bit_width == 64) {
+			return LogicalType::DOUBLE;
+		}
+		break;
+	case DTYPE_BOOL:
+		if (column.bit_width == 1 || column.bit_width == 8) {
+			return LogicalType::BOOLEAN;
+		}
+		break;
+	case DTYPE_DATETIME:
+		// Arrow format strings such as 'tsn:' or 'tsu:UTC', with the unit and the time zone
+		if (column.bit_width == 64 && format.size() >= 4 && format[0] == 't' && format[1] == 's' &&
+		    std::string("smun").find(format[2]) != std::string::npos) {
+			column.unit = format[2];
+			return format.size() > 4 ? LogicalType::TIMESTAMP_TZ : LogicalType::TIMESTAMP;
+		}
+		break;
+	}
+	return LogicalType::INVALID;
+}
+
+// The whole column as a list, through source[name].tolist() (pandas) or .to_list() (polars)
+static PyObject *PyColumnObjects(PyObject *source, const std::string &name) {
+	PyObject *key = PyUnicode_FromString(name.c_str());
+	PyObject *series = PyObject_GetItem(source, key);
+	Py_DECREF(key);
+	if (!series) {
+		throw DataFrameError("Failed to read column '" + name + "' of the dataframe");
+	}
+	const char *method = PyObject_HasAttrString(series, "tolist") ? "tolist" : "to_list";
+	PyObject *values = PyObject_CallMethod(series, method, nullptr);
+	Py_DECREF(series);
+	if (!values) {
+		throw DataFrameError("Failed to convert column '" + name + "' of the dataframe to a list");
+	}
+	PyObject *list = PySequence_List(values);
+	Py_DECREF(values);
+	if (!list) {
+		throw DataFrameError("Column '" + name + "' of the dataframe isn't a sequence");
+	}
+	return list;
+}
+
+// Type of a column of Python objects, from its first value that isn't None. Only iterates the
+// column up to that value, the column is converted as a whole when it is scanned.
+static LogicalType ObjectColumnType(PyObject *source, const std::string &name) {
+	PyObject *key = PyUnicode_FromString(name.c_str());
+	PyObject *series = PyObject_GetItem(source, key);
+	Py_DECREF(key);
+	PyObject *iterator = series ? PyObject_GetIter(series) : nullptr;
+	Py_XDECREF(series);
+	if (!iterator) {
+		throw DataFrameError("Failed to read column '" + name + "' of the dataframe");
+	}
+	PyObject *value;
+	while ((value = PyIter_Next(iterator)) && value == Py_None) {
+		Py_DECREF(value);
+	}
+	Py_DECREF(iterator);
+	if (!value) {
+		if (PyErr_Occurred()) {
+			throw DataFrameError("Failed to read column '" + name + "' of the dataframe");
+		}
+		return LogicalType::VARCHAR;
+	}
+	if (PyLong_Check(value) && !PyBool_Check(value)) {
+		// Python ints are unbounded, INTEGER would turn many of them into nulls
+		Py_DECREF(value);
+		return LogicalType::BIGINT;
+	} else if (PyObject_HasAttrString(value, "as_tuple")) {
+		// A Decimal doesn't tell the width and scale the other rows need, their text keeps every digit
+		Py_DECREF(value);
+		return LogicalType::VARCHAR;
+	}
+	auto types = PyTypesToLogicalTypes({(PyObject *)Py_TYPE(value)});
+	Py_DECREF(value);
+	if (!types.empty() && types[0].id() != LogicalTypeId::INVALID) {
+		return types[0];
+	}
+	return LogicalType::VARCHAR;
+}
+
+PyDataFrame::PyDataFrame(PyObject *source_p) : source(source_p) {
+	Py_INCREF(source);
+	interchange = PyObject_CallMethod(source, "__dataframe__", nullptr);
+	if (!interchange) {
+		Py_DECREF(source);
+		throw DataFrameError("__dataframe__() failed");
+	}
+	auto num_rows = PyMethodLong(interchange, "num_rows", -1);
+	row_count = num_rows < 0 ? DConstants::INVALID_INDEX : num_rows;
+
+	PyObject *names = PyObject_CallMethod(interchange, "column_names", nullptr);
+	PyObject *name_list = names ? PySequence_List(names) : nullptr;
+	Py_XDECREF(names);
+	if (!name_list) {
+		Py_DECREF(interchange);
+		Py_DECREF(source);
+		throw DataFrameError("column_names() of the dataframe failed");
+	}
+	try {
+		for (Py_ssize_t i = 0; i < PyList_Size(name_list); i++) {
+			PyDataFrameColumn column;
+			column.name = PyToString(PyList_GetItem(name_list, i));
+
+			// pandas raises for object columns that don't hold strings
+			PyObject *py_column = PyObject_CallMethod(interchange, "get_column", "n", i);
+			PyObject *dtype = py_column ? PyObject_GetAttrString(py_column, "dtype") : nullptr;
+			Py_XDECREF(py_column);
+			std::string format;
+			if (dtype && PyTuple_Check(dtype) && PyTuple_Size(dtype) >= 3) {
+				column.kind = PyTupleLong(dtype, 0, -1);
+				column.bit_width = PyTupleLong(dtype, 1);
+				// Borrowed reference
+				PyObject *py_format = PyTuple_GetItem(dtype, 2);
+				if (py_format && PyUnicode_Check(py_format)) {
+					format = PyToString(py_format);
+				}
+			}
+			Py_XDECREF(dtype);
+			PyErr_Clear();
+
+			column.type = BufferColumnType(column, format);
+			if (column.type.id() == LogicalTypeId::INVALID) {
+				column.objects = true;
+				column.type = column.kind == DTYPE_STRING ? LogicalType::VARCHAR : ObjectColumnType(source, column.name);
+			}
+			columns.push_back(std::move(column));
+		}
+		if (columns.empty()) {
+			throw InvalidInputException("The dataframe has no columns");
+		}
+	} catch (...) {
+		Py_DECREF(name_list);
+		Py_DECREF(interchange);
+		Py_DECREF(source);
+		throw;
+	}
+	Py_DECREF(name_list);
+}
+
+PyDataFrame::~PyDataFrame() {
+	Py_XDECREF(interchange);
+	Py_XDECREF(source);
+}
+
+PyObject *PyDataFrame::ColumnObjects(const PyDataFrameColumn &column) const {
+	return PyColumnObjects(source, column.name);
+}
+
+PyDataFrameScan::PyDataFrameScan(PyDataFrame &dataframe, const std::vector<column_t> &column_ids)
+    : dataframe(dataframe), column_ids(column_ids), object_columns(column_ids.size(), nullptr),
+      buffer_columns(column_ids.size()) {
+	try {
+		for (idx_t i = 0; i < column_ids.size(); i++) {
+			if (column_ids[i] == COLUMN_IDENTIFIER_ROW_ID) {
+				writers.push_back(nullptr);
+				continue;
+			}
+			auto &column = dataframe.columns[column_ids[i]];
+			writers.push_back(GetColumnWriter(column.type));
+			if (column.objects) {
+				object_columns[i] = dataframe.ColumnObjects(column);
+			}
+		}
+		PyObject *py_chunks = PyObject_CallMethod(dataframe.interchange, "get_chunks", nullptr);
+		chunks = py_chunks ? PySequence_List(py_chunks) : nullptr;
+		Py_XDECREF(py_chunks);
+		if (!chunks) {
+			throw DataFrameError("get_chunks() of the dataframe failed");
+		}
+	} catch (...) {
+		for (auto objects : object_columns) {
+			Py_XDECREF(objects);
+		}
+		throw;
+	}
+}
+
+PyDataFrameScan::~PyDataFrameScan() {
+	ReleaseChunk();
+	for (auto objects : object_columns) {
+		Py_XDECREF(objects);
+	}
+	Py_XDECREF(chunks);
+}
+
+void PyDataFrameScan::ReleaseChunk() {
+	for (auto &column : buffer_columns) {
+		Py_XDECREF(column.buffers);
+		column = PyBufferColumn();
+	}
+}
+
+// Address of the buffer in item 'key' of a get_buffers() dict, nullptr if there's none
+static const_data_ptr_t BufferAddress(PyObject *buffers, const char *key) {
+	// Borrowed references
+	PyObject *entry = PyDict_GetItemString(buffers, key);
+	if (!entry || entry == Py_None || !PyTuple_Check(entry)) {
+		return nullptr;
+	}
+	PyObject *ptr = PyObject_GetAttrString(PyTuple_GetItem(entry, 0), "ptr");
+	if (!ptr) {
+		PyErr_Clear();
+		return nullptr;
+	}
+	auto address = (const_data_ptr_t)PyLong_AsVoidPtr(ptr);
+	Py_DECREF(ptr);
+	PyErr_Clear();
+	return address;
+}
+
+// Moves on to the next interchange chunk, false after the last one
+bool PyDataFrameScan::NextChunk() {
+	ReleaseChunk();
+	chunk_start += chunk_rows;
+	chunk_rows = 0;
+	chunk_position = 0;
+	if (chunk_index >= (idx_t)PyList_Size(chunks)) {
+		return false;
+	}
+	// Borrowed reference
+	PyObject *chunk = PyList_GetItem(chunks, chunk_index++);
+	auto num_rows = PyMethodLong(chunk, "num_rows", -1);
+	if (num_rows < 0) {
+		throw InvalidInputException("A chunk of the dataframe doesn't know its number of rows");
+	}
+	chunk_rows = num_rows;
+
+	for (idx_t i = 0; i < column_ids.size(); i++) {
+		if (!writers[i] || object_columns[i]) {
+			continue;
+		}
+		auto &buffer_column = buffer_columns[i];
+		PyObject *py_column = PyObject_CallMethod(chunk, "get_column", "n", (Py_ssize_t)column_ids[i]);
+		if (!py_column) {
+			throw DataFrameError("Failed to read column '" + dataframe.columns[column_ids[i]].name + "'");
+		}
+		PyObject *offset = PyObject_GetAttrString(py_column, "offset");
+		PyObject *describe_null = PyObject_GetAttrString(py_column, "describe_null");
+		buffer_column.buffers = PyObject_CallMethod(py_column, "get_buffers", nullptr);
+		Py_DECREF(py_column);
+		if (offset) {
+			buffer_column.offset = PyLong_AsSize_t(offset);
+			Py_DECREF(offset);
+		}
+		if (describe_null) {
+			buffer_column.null_kind = PyTupleLong(describe_null, 0);
+			buffer_column.null_value = PyTupleLong(describe_null, 1);
+			Py_DECREF(describe_null);
+		}
+		if (PyErr_Occurred() || !buffer_column.buffers || !PyDict_Check(buffer_column.buffers)) {
+			throw DataFrameError("Failed to read the buffers of column '" + dataframe.columns[column_ids[i]].name +
+			                     "'");
+		}
+		buffer_column.data = BufferAddress(buffer_column.buffers, "data");
+		buffer_column.validity = BufferAddress(buffer_column.buffers, "validity");
+		if (!buffer_column.data || (buffer_column.null_kind >= NULL_BITMASK && !buffer_column.validity)) {
+			throw InvalidInputException("Column '" + dataframe.columns[column_ids[i]].name +
+			                            "' of the dataframe is missing a buffer");
+		}
+	}
+	return true;
+}
+
+// Copies 'count' values from row 'start' of a buffer, marking NaN and sentinel values null
+template <class SRC, class DST>
+static void CopyBuffer(const PyBufferColumn &column, idx_t start, idx_t count, Vector &vector) {
+	auto source = (const SRC *)column.data + column.offset + start;
+	auto target = FlatVector::GetData<DST>(vector);
+	for (idx_t i = 0; i < count; i++) {
+		target[i] = (DST)source[i];
+	}
+	if (column.null_kind == NULL_NAN) {
+		for (idx_t i = 0; i < count; i++) {
+			if (source[i] != source[i]) {
+				FlatVector::SetNull(vector, i, true);
+			}
+		}
+	} else if (column.null_kind == NULL_SENTINEL) {
+		for (idx_t i = 0; i < count; i++) {
+			if (source[i] == (SRC)column.null_value) {
+				FlatVector::SetNull(vector, i, true);
+			}
+		}
+	}
+}
+
+static void CopyBits(const PyBufferColumn &column, idx_t start, idx_t count, Vector &vector) {
+	auto target = FlatVector::GetData<bool>(vector);
+	for (idx_t i = 0; i < count; i++) {
+		auto bit = column.offset + start + i;
+		target[i] = (column.data[bit / 8] >> (bit % 8)) & 1;
+	}
+}
+
+// Timestamps in 'unit' since the epoch, converted to microseconds
+static void CopyTimestamps(const PyBufferColumn &column, char unit, idx_t start, idx_t count, Vector &vector) {
+	auto source = (const int64_t *)column.data + column.offset + start;
+	auto target = FlatVector::GetData<timestamp_t>(vector);
+	for (idx_t i = 0; i < count; i++) {
+		switch (unit) {
+		case 's':
+			target[i] = timestamp_t(source[i] * Interval::MICROS_PER_SEC);
+			break;
+		case 'm':
+			target[i] = timestamp_t(source[i] * Interval::MICROS_PER_MSEC);
+			break;
+		case 'u':
+			target[i] = timestamp_t(source[i]);
+			break;
+		default:
+			target[i] = timestamp_t(source[i] / 1000);
+		}
+		if (column.null_kind == NULL_SENTINEL && source[i] == column.null_value) {
+			FlatVector::SetNull(vector, i, true);
+		}
+	}
+}
+
+static void ApplyMask(const PyBufferColumn &column, idx_t start, idx_t count, Vector &vector) {
+	for (idx_t i = 0; i < count; i++) {
+		auto row = column.offset + start + i;
+		int64_t value = column.null_kind == NULL_BITMASK ? (column.validity[row / 8] >> (row % 8)) & 1
+		                                                 : column.validity[row];
+		if (value == column.null_value) {
+			FlatVector::SetNull(vector, i, true);
+		}
+	}
+}
+
+static void CopyBufferColumn(const PyDataFrameColumn &column, const PyBufferColumn &buffers, idx_t start,
+                             idx_t count, Vector &vector) {
+	switch (column.type.id()) {
+	case LogicalTypeId::TINYINT:
+		CopyBuffer<int8_t, int8_t>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::SMALLINT:
+		CopyBuffer<int16_t, int16_t>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::INTEGER:
+		CopyBuffer<int32_t, int32_t>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::BIGINT:
+		CopyBuffer<int64_t, int64_t>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::UTINYINT:
+		CopyBuffer<uint8_t, uint8_t>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::USMALLINT:
+		CopyBuffer<uint16_t, uint16_t>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::UINTEGER:
+		CopyBuffer<uint32_t, uint32_t>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::UBIGINT:
+		CopyBuffer<uint64_t, uint64_t>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::FLOAT:
+		CopyBuffer<float, float>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::DOUBLE:
+		CopyBuffer<double, double>(buffers, start, count, vector);
+		break;
+	case LogicalTypeId::BOOLEAN:
+		if (column.bit_width == 1) {
+			CopyBits(buffers, start, count, vector);
+		} else {
+			CopyBuffer<uint8_t, bool>(buffers, start, count, vector);
+		}
+		break;
+	case LogicalTypeId::TIMESTAMP:
+	case LogicalTypeId::TIMESTAMP_TZ:
+		CopyTimestamps(buffers, column.unit, start, count, vector);
+		break;
+	default:
+		throw InternalException("Unexpected type of a dataframe buffer column");
+	}
+	if (buffers.null_kind == NULL_BITMASK || buffers.null_kind == NULL_BYTEMASK) {
+		ApplyMask(buffers, start, count, vector);
+	}
+}
+
+bool PyDataFrameScan::Scan(DataChunk &output) {
+	while (chunk_position >= chunk_rows) {
+		if (!NextChunk()) {
+			return false;
+		}
+	}
+	auto count = MinValue<idx_t>(STANDARD_VECTOR_SIZE, chunk_rows - chunk_position);
+	for (idx_t i = 0; i < column_ids.size(); i++) {
+		if (!writers[i]) {
+			continue;
+		}
+		auto &column = dataframe.columns[column_ids[i]];
+		auto &vector = output.data[i];
+		auto objects = object_columns[i];
+		if (!objects) {
+			CopyBufferColumn(column, buffer_columns[i], chunk_position, count, vector);
+			continue;
+		}
+		// Object columns are indexed across all chunks
+		auto start = chunk_start + chunk_position;
+		if (start + count > (idx_t)PyList_Size(objects)) {
+			throw InvalidInputException("Column '" + column.name + "' of the dataframe has fewer rows than expected");
+		}
+		for (idx_t row = 0; row < count; row++) {
+			// Borrowed reference
+			writers[i](PyList_GetItem(objects, start + row), vector, row);
+		}
+	}
+	chunk_position += count;
+	output.SetCardinality(count);
+	return true;
+}
+} // namespace pyudf
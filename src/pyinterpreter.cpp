@@ -0,0 +1,147 @@
+// Sub-interpreters with their own GIL are not part of the limited API the rest of the extension
+// is built against. They're only compiled in when the PYTABLES_SUBINTERPRETERS build option is
+// on, in which case this file alone uses the full C API, and the extension then only loads into
+// the Python minor version it was built for.
+#ifdef PYTABLES_SUBINTERPRETERS
+#undef Py_LIMITED_API
+#endif
+#include <Python.h>
+#include <duckdb.hpp>
+#include <pyinterpreter.hpp>
+#include <python_function.hpp>
+#include <python_exception.hpp>
+#include <stdexcept>
+
+#if defined(PYTABLES_SUBINTERPRETERS) && PY_VERSION_HEX >= 0x030C0000
+#define PYTABLES_OWN_GIL_INTERPRETERS 1
+#endif
+
+namespace pyudf {
+
+#ifdef PYTABLES_OWN_GIL_INTERPRETERS
+
+bool SubInterpreter::Supported() {
+	return true;
+}
+
+// Ends the interpreter of a thread when the thread exits, DuckDB's worker threads do so when the
+// database is closed
+struct ThreadInterpreter {
+	SubInterpreter *interpreter = nullptr;
+
+	~ThreadInterpreter() {
+		delete interpreter;
+	}
+};
+
+SubInterpreter &SubInterpreter::ForCurrentThread() {
+	static thread_local ThreadInterpreter thread_interpreter;
+	if (thread_interpreter.interpreter) {
+		return *thread_interpreter.interpreter;
+	}
+
+	// Creating an interpreter requires holding the main interpreter's GIL
+	PyGILState_STATE gil_state = PyGILState_Ensure();
+	PyThreadState *main_thread_state = PyThreadState_Get();
+
+	PyInterpreterConfig config;
+	config.use_main_obmalloc = 0;
+	config.allow_fork = 0;
+	config.allow_exec = 0;
+	config.allow_threads = 1;
+	config.allow_daemon_threads = 0;
+	config.check_multi_interp_extensions = 1;
+	config.gil = PyInterpreterConfig_OWN_GIL;
+
+	PyThreadState *sub_thread_state = nullptr;
+	PyStatus status = Py_NewInterpreterFromConfig(&sub_thread_state, &config);
+	if (PyStatus_Exception(status)) {
+		PyGILState_Release(gil_state);
+		throw std::runtime_error("Failed to create a Python sub-interpreter: " +
+		                         std::string(status.err_msg ? status.err_msg : "unknown error"));
+	}
+
+	// The new interpreter is now current and we hold its GIL, while the main interpreter's GIL
+	// was released. Drop the new one and switch back so the GILState bookkeeping stays balanced.
+	PyEval_SaveThread();
+	PyEval_RestoreThread(main_thread_state);
+	PyGILState_Release(gil_state);
+
+	thread_interpreter.interpreter = new SubInterpreter();
+	thread_interpreter.interpreter->thread_state = sub_thread_state;
+	return *thread_interpreter.interpreter;
+}
+
+SubInterpreter::~SubInterpreter() {
+	if (!thread_state || !Py_IsInitialized()) {
+		// Python was finalized first, the interpreter went with it
+		return;
+	}
+	PyEval_RestoreThread(thread_state);
+	for (auto &entry : functions) {
+		Py_DECREF(entry.second);
+	}
+	functions.clear();
+	// Releases the interpreter's modules and its GIL, leaving no thread state current
+	Py_EndInterpreter(thread_state);
+}
+
+SubInterpreter::Scope::Scope() : interpreter(ForCurrentThread()) {
+	PyEval_RestoreThread(interpreter.thread_state);
+}
+
+SubInterpreter::Scope::~Scope() {
+	PyEval_SaveThread();
+}
+
+#else
+
+bool SubInterpreter::Supported() {
+	return false;
+}
+
+SubInterpreter &SubInterpreter::ForCurrentThread() {
+	throw std::runtime_error("Python sub-interpreters with their own GIL require building the extension with "
+	                         "PYTABLES_SUBINTERPRETERS=ON against Python 3.12 or newer");
+}
+
+SubInterpreter::~SubInterpreter() {
+}
+
+SubInterpreter::Scope::Scope() : interpreter(ForCurrentThread()) {
+}
+
+SubInterpreter::Scope::~Scope() {
+}
+
+#endif
+
+PyObject *SubInterpreter::function(const std::string &function_specifier) {
+	auto entry = functions.find(function_specifier);
+	if (entry != functions.end()) {
+		return entry->second;
+	}
+
+	std::string module_name;
+	std::string function_name;
+	std::tie(module_name, function_name) = parse_func_specifier(function_specifier);
+	PyObject *module = PyImport_ImportModule(module_name.c_str());
+	if (!module) {
+		// Most likely a C extension that doesn't support multiple interpreters
+		PythonException error;
+		throw std::runtime_error("Failed to import module: " + module_name + " (" + error.message + ")");
+	}
+	PyObject *function = PyObject_GetAttrString(module, function_name.c_str());
+	Py_DECREF(module);
+	if (!function) {
+		PyErr_Clear();
+		throw std::runtime_error("Failed to find function: " + function_name);
+	}
+	if (!PyCallable_Check(function)) {
+		Py_DECREF(function);
+		throw std::runtime_error("Function is not callable: " + function_name);
+	}
+	functions[function_specifier] = function;
+	return function;
+}
+} // namespace pyudf
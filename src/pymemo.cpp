@@ -0,0 +1,184 @@
+#include <duckdb.hpp>
+#include <duckdb/function/table_function.hpp>
+#include <pymemo.hpp>
+
+using namespace duckdb;
+namespace pyudf {
+
+shared_ptr<PyMemoStats> PyMemoStats::Get(ClientContext &context) {
+	return ObjectCache::GetObjectCache(context).GetOrCreate<PyMemoStats>(ObjectType());
+}
+
+void PyMemoStats::Record(const std::string &function, idx_t hits, idx_t misses) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto &entry = counters[function];
+	entry.first += hits;
+	entry.second += misses;
+}
+
+std::vector<std::tuple<std::string, idx_t, idx_t>> PyMemoStats::Counters() {
+	std::lock_guard<std::mutex> guard(lock);
+	std::vector<std::tuple<std::string, idx_t, idx_t>> result;
+	for (auto &entry : counters) {
+		result.emplace_back(entry.first, entry.second.first, entry.second.second);
+	}
+	return result;
+}
+
+// Bytes of a value of a fixed size type, 0 for strings and blobs
+static idx_t FixedSize(const LogicalType &type) {
+	auto physical = type.InternalType();
+	return physical == PhysicalType::VARCHAR ? 0 : GetTypeIdSize(physical);
+}
+
+bool PyMemo::Supports(const LogicalType &type) {
+	auto physical = type.InternalType();
+	return physical == PhysicalType::VARCHAR || TypeIsConstantSize(physical);
+}
+
+void PyMemo::SetArguments(DataChunk &args) {
+	arguments.resize(args.ColumnCount());
+	argument_sizes.resize(args.ColumnCount());
+	for (idx_t i = 0; i < args.ColumnCount(); i++) {
+		args.data[i].ToUnifiedFormat(args.size(), arguments[i]);
+		argument_sizes[i] = FixedSize(args.data[i].GetType());
+	}
+	key_row = DConstants::INVALID_INDEX;
+}
+
+void PyMemo::BuildKey(idx_t row) {
+	if (key_row == row) {
+		return;
+	}
+	key.clear();
+	for (idx_t i = 0; i < arguments.size(); i++) {
+		auto &format = arguments[i];
+		auto idx = format.sel->get_index(row);
+		if (!format.validity.RowIsValid(idx)) {
+			key.push_back(0);
+			continue;
+		}
+		key.push_back(1);
+		if (argument_sizes[i]) {
+			key.append((const char *)format.data + idx * argument_sizes[i], argument_sizes[i]);
+			continue;
+		}
+		// Strings are prefixed with their length, so neighbouring arguments can't run together
+		auto &value = ((const string_t *)format.data)[idx];
+		uint32_t size = value.GetSize();
+		key.append((const char *)&size, sizeof(size));
+		key.append(value.GetData(), size);
+	}
+	key_row = row;
+}
+
+bool PyMemo::Lookup(idx_t row, Vector &result) {
+	BuildKey(row);
+	auto entry = results.find(key);
+	if (entry == results.end()) {
+		misses++;
+		return false;
+	}
+	hits++;
+	auto &encoded = entry->second;
+	if (encoded[0] == 0) {
+		FlatVector::SetNull(result, row, true);
+		return true;
+	}
+	auto size = FixedSize(result.GetType());
+	if (size) {
+		memcpy(FlatVector::GetData(result) + row * size, encoded.data() + 1, size);
+	} else {
+		FlatVector::GetData<string_t>(result)[row] =
+		    StringVector::AddStringOrBlob(result, encoded.data() + 1, encoded.size() - 1);
+	}
+	return true;
+}
+
+void PyMemo::Store(idx_t row, Vector &result) {
+	if (results.size() >= MAX_ENTRIES) {
+		return;
+	}
+	BuildKey(row);
+	std::string encoded;
+	if (FlatVector::IsNull(result, row)) {
+		encoded.push_back(0);
+	} else {
+		encoded.push_back(1);
+		auto size = FixedSize(result.GetType());
+		if (size) {
+			encoded.append((const char *)FlatVector::GetData(result) + row * size, size);
+		} else {
+			auto &value = FlatVector::GetData<string_t>(result)[row];
+			encoded.append(value.GetData(), value.GetSize());
+		}
+	}
+	results.emplace(key, std::move(encoded));
+}
+
+const std::string &PyMemo::RowKey(idx_t row) {
+	BuildKey(row);
+	return key;
+}
+
+void PyMemo::CopyResult(Vector &result, idx_t source, idx_t target) {
+	if (FlatVector::IsNull(result, source)) {
+		FlatVector::SetNull(result, target, true);
+		return;
+	}
+	auto size = FixedSize(result.GetType());
+	auto data = FlatVector::GetData(result);
+	if (size) {
+		memcpy(data + target * size, data + source * size, size);
+	} else {
+		// Both rows can point to the same string in the vector's heap
+		((string_t *)data)[target] = ((string_t *)data)[source];
+	}
+}
+
+void PyMemo::Flush(const std::string &function) {
+	if (hits || misses) {
+		stats->Record(function, hits, misses);
+		hits = 0;
+		misses = 0;
+	}
+}
+
+struct PyMemoStatsScanState : public GlobalTableFunctionState {
+	std::vector<std::tuple<std::string, idx_t, idx_t>> counters;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> PyMemoStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                vector<LogicalType> &return_types, vector<string> &names) {
+	names = {"function", "hits", "misses", "hit_rate"};
+	return_types = {LogicalType::VARCHAR, LogicalType::BIGINT, LogicalType::BIGINT, LogicalType::DOUBLE};
+	return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> PyMemoStatsInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto state = make_uniq<PyMemoStatsScanState>();
+	state->counters = PyMemoStats::Get(context)->Counters();
+	return std::move(state);
+}
+
+static void PyMemoStatsScan(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = (PyMemoStatsScanState &)*data.global_state;
+	idx_t row = 0;
+	for (; state.offset < state.counters.size() && row < STANDARD_VECTOR_SIZE; state.offset++, row++) {
+		auto &counter = state.counters[state.offset];
+		auto hits = std::get<1>(counter);
+		auto misses = std::get<2>(counter);
+		output.SetValue(0, row, Value(std::get<0>(counter)));
+		output.SetValue(1, row, Value::BIGINT(hits));
+		output.SetValue(2, row, Value::BIGINT(misses));
+		output.SetValue(3, row, Value::DOUBLE(hits + misses == 0 ? 0 : (double)hits / (hits + misses)));
+	}
+	output.SetCardinality(row);
+}
+
+unique_ptr<CreateTableFunctionInfo> GetPyMemoStatsFunction() {
+	TableFunction stats_function("pycall_memo_stats", {}, PyMemoStatsScan, PyMemoStatsBind, PyMemoStatsInit);
+	return make_uniq<CreateTableFunctionInfo>(stats_function);
+}
+} // namespace pyudf
@@ -1,34 +1,239 @@
 #include "duckdb.hpp"
 #include "duckdb/common/string_util.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/expression_executor_state.hpp"
 #include "duckdb/function/scalar_function.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
 #include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
 #include <Python.h>
 #include <string>
 #include <iostream>
+#include <unordered_map>
 #include "python_function.hpp"
 #include "pyconvert.hpp"
+#include <cpy/object.hpp>
+#include <cpy/gil.hpp>
 #include <log.hpp>
+#include <pyasync.hpp>
+#include <pyinterpreter.hpp>
+#include <pymemo.hpp>
+#include <pysettings.hpp>
+#include <pyworker.hpp>
 
 using namespace duckdb;
 namespace pyudf {
 
-static void PyScalarFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+struct PyScalarBindData : public FunctionData {
+	// The 'module:func' argument if it was a constant, empty otherwise
+	std::string function_specifier;
+
+	// Callable resolved once at bind time for a constant function specifier. Null
+	// when the specifier is a column value and has to be resolved per row.
+	shared_ptr<PythonFunction> function;
+
+	// Vectorized functions that set 'pytables_buffers' get INTEGER/BIGINT/DOUBLE columns
+	// as memoryviews instead of lists.
+	bool buffers = false;
+
+	// Writes Python results straight into the result vector, picked from the return type
+	py_column_writer_t result_writer = nullptr;
+
+	// Convert the arguments after the function specifier, picked from their types
+	std::vector<py_column_reader_t> argument_readers;
+
+	// Where the function runs, see the pytables_isolation setting
+	PyIsolation isolation = PyIsolation::NONE;
+
+	// Size of the worker process pool for PyIsolation::PROCESS
+	idx_t worker_processes = 0;
+
+	// Functions that set 'pytables_memoize' are only called once per distinct arguments
+	bool memoize = false;
+
+	// 'async def' functions have a chunk's calls run concurrently, at most this many at a time
+	bool coroutine = false;
+	idx_t async_concurrency = 0;
+
+	unique_ptr<FunctionData> Copy() const override {
+		auto copy = make_uniq<PyScalarBindData>();
+		copy->function_specifier = function_specifier;
+		copy->function = function;
+		copy->buffers = buffers;
+		copy->result_writer = result_writer;
+		copy->argument_readers = argument_readers;
+		copy->isolation = isolation;
+		copy->worker_processes = worker_processes;
+		copy->memoize = memoize;
+		copy->coroutine = coroutine;
+		copy->async_concurrency = async_concurrency;
+		return std::move(copy);
+	}
+
+	bool Equals(const FunctionData &other_p) const override {
+		auto &other = (const PyScalarBindData &)other_p;
+		return function_specifier == other.function_specifier && function == other.function &&
+		       buffers == other.buffers && isolation == other.isolation &&
+		       worker_processes == other.worker_processes && memoize == other.memoize &&
+		       coroutine == other.coroutine && async_concurrency == other.async_concurrency;
+	}
+};
+
+struct PyScalarLocalState : public FunctionLocalState {
+	// Callables resolved from non-constant function specifiers, keyed by the 'module:func'
+	// string, so each distinct specifier is only imported once per expression state.
+	std::unordered_map<std::string, unique_ptr<PythonFunction>> functions;
+
+	// Results by arguments when the function is memoized
+	unique_ptr<PyMemo> memo;
+};
+
+static PythonFunction &GetFunction(PyScalarBindData &bind_data, PyScalarLocalState &local_state, Vector &funcspec,
+                                   idx_t row) {
+	if (bind_data.function) {
+		return *bind_data.function;
+	}
+	auto funcspec_value = funcspec.GetValue(row).GetValue<std::string>();
+	auto entry = local_state.functions.find(funcspec_value);
+	if (entry != local_state.functions.end()) {
+		return *entry->second;
+	}
+	auto func = make_uniq<PythonFunction>(funcspec_value);
+	auto &result = *func;
+	local_state.functions[funcspec_value] = std::move(func);
+	return result;
+}
+
+// Runs the chunk in this thread's sub-interpreter, which has a GIL of its own so that
+// DuckDB's threads don't serialize on the main interpreter's.
+static void PySubInterpreterScalarFunction(PyScalarBindData &bind_data, PyScalarLocalState &local_state,
+                                           DataChunk &args, Vector &result) {
+	SubInterpreter::Scope scope;
+	PyObject *func = scope.interpreter.function(bind_data.function_specifier);
+	PyRowReader reader(bind_data.argument_readers, args, 1);
+	if (local_state.memo) {
+		local_state.memo->SetArguments(args);
+	}
 	for (idx_t row = 0; row < args.size(); row++) {
-		// Grab the FunctionSpecifier argument. In practice this is almost always going
-		// to be constants, but in theory they could be column values.
-		auto &funcspec_column = args.data[0];
-		auto funcspec_value = funcspec_column.GetValue(row).GetValue<std::string>();
-		auto func = PythonFunction(funcspec_value);
+		if (local_state.memo && local_state.memo->Lookup(row, result)) {
+			continue;
+		}
+		auto pyargs = reader.Row(row);
+		PyObject *pyresult = PyObject_CallObject(func, pyargs);
+		Py_DECREF(pyargs);
+		if (!pyresult) {
+			PythonException error;
+			throw std::runtime_error(error.message);
+		}
+		bind_data.result_writer(pyresult, result, row);
+		Py_DECREF(pyresult);
+		if (local_state.memo) {
+			local_state.memo->Store(row, result);
+		}
+	}
+	if (local_state.memo) {
+		local_state.memo->Flush(bind_data.function_specifier);
+	}
+}
 
-		std::vector<duckdb::Value> duck_args;
+// Runs the chunk's calls of an 'async def' function concurrently on this thread's event loop.
+// The results come back in row order. Memoized functions only await the first row of each
+// distinct arguments that have no remembered result.
+static void PyAsyncScalarRows(PyScalarBindData &bind_data, PyScalarLocalState &local_state, DataChunk &args,
+                              Vector &result) {
+	auto memo = local_state.memo.get();
+	std::vector<idx_t> pending;
+	// Rows repeating the arguments of a pending row, and that row
+	std::vector<std::pair<idx_t, idx_t>> repeats;
+	std::unordered_map<std::string, idx_t> pending_rows;
+	if (memo) {
+		memo->SetArguments(args);
+	}
+	for (idx_t row = 0; row < args.size(); row++) {
+		if (!memo) {
+			pending.push_back(row);
+			continue;
+		} else if (memo->Lookup(row, result)) {
+			continue;
+		}
+		auto entry = pending_rows.emplace(memo->RowKey(row), row);
+		if (entry.second) {
+			pending.push_back(row);
+		} else {
+			repeats.emplace_back(row, entry.first->second);
+		}
+	}
+	if (pending.empty()) {
+		// Every row was remembered, only memoized functions get here
+		memo->Flush(bind_data.function_specifier);
+		return;
+	}
 
-		for (idx_t i = 1; i < args.ColumnCount(); i++) {
-			// Fill the tuple with the arguments for this row
-			auto &column = args.data[i];
-			auto value = column.GetValue(row);
-			duck_args.emplace_back(value);
+	PyRowReader reader(bind_data.argument_readers, args, 1);
+	PyObject *argument_tuples = PyList_New(pending.size());
+	for (idx_t i = 0; i < pending.size(); i++) {
+		// Steals the reference
+		PyList_SetItem(argument_tuples, i, reader.Row(pending[i]));
+	}
+	PyObject *results = GatherAsync(bind_data.function->callable(), argument_tuples, bind_data.async_concurrency);
+	Py_DECREF(argument_tuples);
+	if (!results) {
+		PythonException error;
+		throw std::runtime_error(error.message);
+	}
+	try {
+		for (idx_t i = 0; i < pending.size(); i++) {
+			// Borrowed reference
+			bind_data.result_writer(PyList_GetItem(results, i), result, pending[i]);
+			if (memo) {
+				memo->Store(pending[i], result);
+			}
 		}
-		auto pyargs = duckdbs_to_pys(duck_args);
+	} catch (...) {
+		Py_DECREF(results);
+		throw;
+	}
+	Py_DECREF(results);
+	for (auto &repeat : repeats) {
+		PyMemo::CopyResult(result, repeat.second, repeat.first);
+	}
+	if (memo) {
+		memo->Flush(bind_data.function_specifier);
+	}
+}
+
+// Calls the function for every row of 'args', writing flat results
+static void PyScalarRows(PyScalarBindData &bind_data, PyScalarLocalState &local_state, DataChunk &args,
+                         Vector &result) {
+	if (bind_data.isolation == PyIsolation::SUBINTERPRETER) {
+		PySubInterpreterScalarFunction(bind_data, local_state, args, result);
+		return;
+	} else if (bind_data.isolation == PyIsolation::PROCESS) {
+		CallInWorkerProcess(bind_data.function_specifier, bind_data.worker_processes, args, 1, result);
+		return;
+	}
+
+	// Held for the whole chunk and released in between, so DuckDB's other threads (and
+	// other Python functions) can make progress while this chunk moves on through the plan.
+	cpy::GIL gil;
+	if (bind_data.coroutine) {
+		PyAsyncScalarRows(bind_data, local_state, args, result);
+		return;
+	}
+
+	PyRowReader reader(bind_data.argument_readers, args, 1);
+	if (local_state.memo) {
+		local_state.memo->SetArguments(args);
+	}
+	for (idx_t row = 0; row < args.size(); row++) {
+		// Repeated arguments are answered before anything is converted to Python
+		if (local_state.memo && local_state.memo->Lookup(row, result)) {
+			continue;
+		}
+
+		// Grab the FunctionSpecifier argument. In practice this is almost always going
+		// to be a constant resolved during bind, but in theory it could be column values.
+		auto &func = GetFunction(bind_data, local_state, args.data[0], row);
+		auto pyargs = reader.Row(row);
 
 		PyObject *pyresult;
 		PythonException *error;
@@ -39,21 +244,338 @@ static void PyScalarFunction(DataChunk &args, ExpressionState &state, Vector &re
 			error->~PythonException();
 			throw std::runtime_error(err);
 		} else {
-			auto ddb_result = ConvertPyObjectToDuckDBValue(pyresult, duckdb::LogicalTypeId::VARCHAR);
-			result.SetValue(row, ddb_result);
+			bind_data.result_writer(pyresult, result, row);
 			Py_DECREF(pyargs);
 			Py_DECREF(pyresult);
 		}
+		if (local_state.memo) {
+			local_state.memo->Store(row, result);
+		}
+	}
+	if (local_state.memo) {
+		local_state.memo->Flush(bind_data.function_specifier);
 	}
 }
 
+// Evaluates a chunk whose non-constant arguments are all dictionary vectors over the same
+// selection, calling the function once per dictionary entry the chunk uses. The result is a
+// dictionary vector over those results. Returns false for any other chunk.
+static bool PyScalarDictionary(PyScalarBindData &bind_data, PyScalarLocalState &local_state, DataChunk &args,
+                               Vector &result) {
+	const SelectionVector *selection = nullptr;
+	for (auto &column : args.data) {
+		if (column.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+			continue;
+		} else if (column.GetVectorType() != VectorType::DICTIONARY_VECTOR) {
+			return false;
+		}
+		auto &column_selection = DictionaryVector::SelVector(column);
+		if (selection && selection->data() != column_selection.data()) {
+			return false;
+		}
+		selection = &column_selection;
+	}
+	if (!selection) {
+		return false;
+	}
+
+	// Position of each used dictionary entry among the distinct entries, in order of first use
+	std::unordered_map<idx_t, idx_t> positions;
+	SelectionVector distinct(args.size());
+	SelectionVector result_selection(args.size());
+	for (idx_t row = 0; row < args.size(); row++) {
+		auto entry = selection->get_index(row);
+		auto position = positions.find(entry);
+		if (position == positions.end()) {
+			position = positions.emplace(entry, positions.size()).first;
+			distinct.set_index(position->second, entry);
+		}
+		result_selection.set_index(row, position->second);
+	}
+	if (positions.size() == args.size()) {
+		// No repeats to save calls on
+		return false;
+	}
+
+	DataChunk distinct_args;
+	distinct_args.InitializeEmpty(args.GetTypes());
+	for (idx_t i = 0; i < args.ColumnCount(); i++) {
+		if (args.data[i].GetVectorType() == VectorType::CONSTANT_VECTOR) {
+			distinct_args.data[i].Reference(args.data[i]);
+		} else {
+			distinct_args.data[i].Slice(DictionaryVector::Child(args.data[i]), distinct, positions.size());
+		}
+	}
+	distinct_args.SetCardinality(positions.size());
+
+	Vector distinct_results(result.GetType(), positions.size());
+	PyScalarRows(bind_data, local_state, distinct_args, distinct_results);
+	result.Slice(distinct_results, result_selection, args.size());
+	return true;
+}
+
+static void PyScalarFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &func_expr = (BoundFunctionExpression &)state.expr;
+	auto &bind_data = (PyScalarBindData &)*func_expr.bind_info;
+	auto &local_state = (PyScalarLocalState &)*ExecuteFunctionState::GetFunctionState(state);
+	if (args.size() == 0) {
+		return;
+	}
+
+	if (args.AllConstant()) {
+		// Same arguments for every row, so a single call covers the chunk
+		DataChunk constant_args;
+		constant_args.InitializeEmpty(args.GetTypes());
+		constant_args.Reference(args);
+		constant_args.SetCardinality(1);
+		PyScalarRows(bind_data, local_state, constant_args, result);
+		result.SetVectorType(VectorType::CONSTANT_VECTOR);
+		return;
+	}
+	if (PyScalarDictionary(bind_data, local_state, args, result)) {
+		return;
+	}
+	PyScalarRows(bind_data, local_state, args, result);
+}
+
+// Maps a function's return annotation, either a Python type such as 'float' or a DuckDB type
+// name such as 'BIGINT', to a DuckDB type. VARCHAR if there is no usable annotation. Scalar
+// functions don't support named parameters, so this is the only way to declare a return type.
+static LogicalType ReturnTypeFromAnnotation(ClientContext &context, PythonFunction &func) {
+	PyObject *annotation = func.return_annotation();
+	if (!annotation) {
+		return LogicalType::VARCHAR;
+	}
+	cpy::Object annotation_obj(annotation, true);
+	if (PyUnicode_Check(annotation)) {
+		return TransformStringToLogicalType(annotation_obj.str(), context);
+	} else if (annotation == (PyObject *)&PyLong_Type) {
+		// Python ints are unbounded, an INTEGER result would turn many of them into nulls
+		return LogicalType::BIGINT;
+	}
+	auto types = PyTypesToLogicalTypes({annotation});
+	if (types.empty() || types[0].id() == LogicalTypeId::INVALID) {
+		return LogicalType::VARCHAR;
+	}
+	return types[0];
+}
+
+static unique_ptr<PyScalarBindData> BindFunctionSpecifier(ClientContext &context, ScalarFunction &bound_function,
+                                                          vector<unique_ptr<Expression>> &arguments) {
+	auto bind_data = make_uniq<PyScalarBindData>();
+	auto &funcspec = *arguments[0];
+	if (funcspec.IsFoldable()) {
+		cpy::GIL gil;
+		// The function specifier is a constant, so import the module and look up the
+		// function once here instead of once for every row.
+		auto funcspec_value = ExpressionExecutor::EvaluateScalar(context, funcspec);
+		if (!funcspec_value.IsNull()) {
+			bind_data->function_specifier = funcspec_value.GetValue<std::string>();
+			bind_data->function = make_shared<PythonFunction>(bind_data->function_specifier);
+			bound_function.return_type = ReturnTypeFromAnnotation(context, *bind_data->function);
+		}
+	}
+	bind_data->result_writer = GetColumnWriter(bound_function.return_type);
+	for (idx_t i = 1; i < arguments.size(); i++) {
+		bind_data->argument_readers.push_back(GetColumnReader(arguments[i]->return_type));
+	}
+	return bind_data;
+}
+
+// Binds a function that runs in a worker process. Nothing is imported here, the return
+// annotation is looked up by a worker instead.
+static unique_ptr<FunctionData> PyWorkerScalarBind(ClientContext &context, ScalarFunction &bound_function,
+                                                   vector<unique_ptr<Expression>> &arguments) {
+	auto bind_data = make_uniq<PyScalarBindData>();
+	auto &funcspec = *arguments[0];
+	Value funcspec_value;
+	if (funcspec.IsFoldable()) {
+		funcspec_value = ExpressionExecutor::EvaluateScalar(context, funcspec);
+	}
+	if (funcspec_value.IsNull()) {
+		throw BinderException("pytables_isolation requires a constant 'module:func' function specifier");
+	}
+	bind_data->function_specifier = funcspec_value.GetValue<std::string>();
+	bind_data->isolation = PyIsolation::PROCESS;
+	bind_data->worker_processes = GetWorkerProcesses(context);
+	auto type_name = DescribeInWorkerProcess(bind_data->function_specifier, bind_data->worker_processes);
+	if (!type_name.empty()) {
+		bound_function.return_type = TransformStringToLogicalType(type_name, context);
+	}
+	return std::move(bind_data);
+}
+
+static unique_ptr<FunctionData> PyScalarBind(ClientContext &context, ScalarFunction &bound_function,
+                                             vector<unique_ptr<Expression>> &arguments) {
+	auto isolation = GetIsolation(context);
+	if (isolation == PyIsolation::PROCESS) {
+		return PyWorkerScalarBind(context, bound_function, arguments);
+	}
+	auto bind_data = BindFunctionSpecifier(context, bound_function, arguments);
+	if (isolation == PyIsolation::SUBINTERPRETER) {
+		if (!bind_data->function) {
+			throw BinderException("pytables_isolation requires a constant 'module:func' function specifier");
+		}
+		bind_data->isolation = isolation;
+	}
+	if (bind_data->function) {
+		cpy::GIL gil;
+		bind_data->memoize = bind_data->function->has_flag("pytables_memoize");
+		bind_data->coroutine = bind_data->function->is_coroutine_function();
+		bind_data->async_concurrency = GetAsyncConcurrency(context);
+	}
+	if (bind_data->coroutine && isolation == PyIsolation::SUBINTERPRETER) {
+		throw BinderException("'async def' functions can't be called with pytables_isolation 'subinterpreter'");
+	}
+	if (bind_data->memoize) {
+		// Results are remembered by the bytes of the arguments, which nested types don't have
+		for (auto &argument : arguments) {
+			if (!PyMemo::Supports(argument->return_type)) {
+				throw BinderException("Memoized functions can't take arguments of type " +
+				                      argument->return_type.ToString());
+			}
+		}
+		if (!PyMemo::Supports(bound_function.return_type)) {
+			throw BinderException("Memoized functions can't return " + bound_function.return_type.ToString());
+		}
+	}
+	return std::move(bind_data);
+}
+
+static void CopyPySequenceToVector(PyScalarBindData &bind_data, PyObject *pyresult, Vector &result, idx_t count) {
+	// Accept any sequence (list, tuple, generator, ...) of results
+	PyObject *pylist = PySequence_List(pyresult);
+	if (!pylist) {
+		PythonException err;
+		throw InvalidInputException("Function '" + bind_data.function_specifier +
+		                            "' did not return a sequence of results: " + err.message);
+	}
+	auto result_count = (idx_t)PyList_Size(pylist);
+	if (result_count != count) {
+		Py_DECREF(pylist);
+		throw InvalidInputException("Function '" + bind_data.function_specifier + "' returned " +
+		                            std::to_string(result_count) + " values for a chunk of " + std::to_string(count) +
+		                            " rows");
+	}
+	for (idx_t row = 0; row < count; row++) {
+		// Borrowed reference, no decref needed
+		PyObject *item = PyList_GetItem(pylist, row);
+		bind_data.result_writer(item, result, row);
+	}
+	Py_DECREF(pylist);
+}
+
+// Arguments of a vectorized call. Memoryviews handed to Python point straight into the
+// argument vectors, so they are released once the call is complete.
+struct PyVectorizedArguments {
+	PyObject *pyargs = nullptr;
+	std::vector<PyObject *> buffers;
+
+	bool Release() {
+		bool released = true;
+		for (auto buffer : buffers) {
+			released = ReleasePyBuffer(buffer) && released;
+		}
+		buffers.clear();
+		return released;
+	}
+
+	~PyVectorizedArguments() {
+		Release();
+		Py_XDECREF(pyargs);
+	}
+};
+
+static void PyVectorizedScalarFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto &func_expr = (BoundFunctionExpression &)state.expr;
+	auto &bind_data = (PyScalarBindData &)*func_expr.bind_info;
+	auto count = args.size();
+	if (0 == count) {
+		return;
+	}
+
+	cpy::GIL gil;
+
+	// One list (or buffer) per argument column, so the whole chunk costs a single Python call
+	PyVectorizedArguments arguments;
+	arguments.pyargs = PyTuple_New(args.ColumnCount() - 1);
+	for (idx_t i = 1; i < args.ColumnCount(); i++) {
+		PyObject *arg = nullptr;
+		if (bind_data.buffers) {
+			arg = VectorToPyBuffer(args.data[i], count);
+			if (arg) {
+				arguments.buffers.push_back(arg);
+			}
+		}
+		if (!arg) {
+			arg = VectorToPyList(args.data[i], count);
+		}
+		PyTuple_SetItem(arguments.pyargs, i - 1, arg);
+	}
+
+	PyObject *pyresult;
+	PythonException *error;
+	std::tie(pyresult, error) = bind_data.function->call(arguments.pyargs);
+	if (!pyresult) {
+		std::string err = error->message;
+		error->~PythonException();
+		throw std::runtime_error(err);
+	}
+
+	try {
+		bool copied = bind_data.buffers && PyBufferToVector(pyresult, result, count);
+		if (!copied) {
+			CopyPySequenceToVector(bind_data, pyresult, result, count);
+		}
+	} catch (...) {
+		Py_DECREF(pyresult);
+		throw;
+	}
+	Py_DECREF(pyresult);
+
+	if (!arguments.Release()) {
+		throw InvalidInputException("Function '" + bind_data.function_specifier +
+		                            "' kept a reference to one of its argument buffers after returning");
+	}
+}
+
+static unique_ptr<FunctionData> PyVectorizedScalarBind(ClientContext &context, ScalarFunction &bound_function,
+                                                       vector<unique_ptr<Expression>> &arguments) {
+	auto bind_data = BindFunctionSpecifier(context, bound_function, arguments);
+	if (!bind_data->function) {
+		throw BinderException("pycall_vectorized requires a constant 'module:func' function specifier");
+	}
+	bind_data->buffers = bind_data->function->has_flag("pytables_buffers");
+	return std::move(bind_data);
+}
+
+static unique_ptr<FunctionLocalState> PyScalarInitLocalState(ExpressionState &state,
+                                                             const BoundFunctionExpression &expr,
+                                                             FunctionData *bind_data) {
+	auto local_state = make_uniq<PyScalarLocalState>();
+	if (bind_data && ((PyScalarBindData &)*bind_data).memoize) {
+		local_state->memo = make_uniq<PyMemo>(PyMemoStats::Get(state.GetContext()));
+	}
+	return std::move(local_state);
+}
+
 CreateScalarFunctionInfo GetPythonScalarFunction() {
 	auto scalar_func = ScalarFunction("pycall", {LogicalType::VARCHAR}, LogicalType::VARCHAR, PyScalarFunction);
 	scalar_func.varargs = LogicalType::ANY;
+	scalar_func.bind = PyScalarBind;
+	scalar_func.init_local_state = PyScalarInitLocalState;
 
 	// 'named_parameters' does not appear to be supported for scalar functions
 	// scalar_func.named_parameters["kwargs"] = LogicalType::ANY;
 	CreateScalarFunctionInfo py_scalar_function_info(scalar_func);
 	return CreateScalarFunctionInfo(py_scalar_function_info);
 }
+
+CreateScalarFunctionInfo GetPythonVectorizedScalarFunction() {
+	auto scalar_func =
+	    ScalarFunction("pycall_vectorized", {LogicalType::VARCHAR}, LogicalType::VARCHAR, PyVectorizedScalarFunction);
+	scalar_func.varargs = LogicalType::ANY;
+	scalar_func.bind = PyVectorizedScalarBind;
+	return CreateScalarFunctionInfo(scalar_func);
+}
 } // namespace pyudf
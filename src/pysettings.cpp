@@ -0,0 +1,146 @@
+#include <duckdb.hpp>
+#include <pysettings.hpp>
+#include <pyinterpreter.hpp>
+#include <thread>
+
+using namespace duckdb;
+namespace pyudf {
+
+static PyIsolation ParseIsolation(const std::string &isolation) {
+	auto lowered = StringUtil::Lower(isolation);
+	if (lowered == "none") {
+		return PyIsolation::NONE;
+	} else if (lowered == "subinterpreter") {
+		if (!SubInterpreter::Supported()) {
+			throw InvalidInputException("pytables_isolation 'subinterpreter' requires the extension to be built with "
+			                            "PYTABLES_SUBINTERPRETERS=ON against Python 3.12 or newer");
+		}
+		return PyIsolation::SUBINTERPRETER;
+	} else if (lowered == "process") {
+		return PyIsolation::PROCESS;
+	}
+	throw InvalidInputException("Unknown pytables_isolation '" + isolation +
+	                            "', expected 'none', 'subinterpreter' or 'process'");
+}
+
+static void SetIsolation(ClientContext &context, SetScope scope, Value &parameter) {
+	// Only validates, DuckDB stores the value
+	ParseIsolation(parameter.GetValue<std::string>());
+}
+
+static void SetWorkerProcesses(ClientContext &context, SetScope scope, Value &parameter) {
+	if (parameter.GetValue<int64_t>() < 0) {
+		throw InvalidInputException("pytables_worker_processes must not be negative");
+	}
+}
+
+static void SetCacheTTL(ClientContext &context, SetScope scope, Value &parameter) {
+	if (parameter.GetValue<int64_t>() < 0) {
+		throw InvalidInputException("pytables_cache_ttl must not be negative");
+	}
+}
+
+// Validates settings holding an amount of memory, such as '256MB'
+static void SetMemorySize(ClientContext &context, SetScope scope, Value &parameter) {
+	DBConfig::ParseMemoryLimit(parameter.GetValue<std::string>());
+}
+
+static void SetAsyncConcurrency(ClientContext &context, SetScope scope, Value &parameter) {
+	if (parameter.GetValue<int64_t>() < 1) {
+		throw InvalidInputException("pytables_async_concurrency must be at least 1");
+	}
+}
+
+static void SetPrefetchChunks(ClientContext &context, SetScope scope, Value &parameter) {
+	if (parameter.GetValue<int64_t>() < 0) {
+		throw InvalidInputException("pytables_prefetch_chunks must not be negative");
+	}
+}
+
+void RegisterSettings(DBConfig &config) {
+	config.AddExtensionOption("pytables_isolation",
+	                          "How pycall runs Python functions: 'none' runs everything in the main interpreter, "
+	                          "'subinterpreter' gives each DuckDB thread its own interpreter and GIL (Python 3.12+), "
+	                          "'process' sends each chunk to a pool of Python worker processes",
+	                          LogicalType::VARCHAR, Value("none"), SetIsolation);
+	config.AddExtensionOption("pytables_worker_processes",
+	                          "Maximum number of Python worker processes for pytables_isolation 'process', 0 for one "
+	                          "per CPU core",
+	                          LogicalType::BIGINT, Value::BIGINT(0), SetWorkerProcesses);
+	config.AddExtensionOption("pytables_cache_ttl",
+	                          "Seconds that pytable results are cached for and replayed by repeated calls, 0 disables "
+	                          "the cache",
+	                          LogicalType::BIGINT, Value::BIGINT(0), SetCacheTTL);
+	config.AddExtensionOption("pytables_cache_size", "Maximum memory used by cached pytable results, e.g. '256MB'",
+	                          LogicalType::VARCHAR, Value("256MB"), SetMemorySize);
+	config.AddExtensionOption("pytables_async_concurrency",
+	                          "Maximum number of calls of an 'async def' pycall function in flight at once per thread",
+	                          LogicalType::BIGINT, Value::BIGINT(64), SetAsyncConcurrency);
+	config.AddExtensionOption("pytables_prefetch_chunks",
+	                          "Chunks of rows pytable reads ahead of the query on a thread of its own, 0 reads rows "
+	                          "only when the query asks for them",
+	                          LogicalType::BIGINT, Value::BIGINT(0), SetPrefetchChunks);
+	config.AddExtensionOption("pytables_prefetch_memory",
+	                          "Maximum memory held by the chunks pytable has read ahead of the query, e.g. '64MB'",
+	                          LogicalType::VARCHAR, Value("64MB"), SetMemorySize);
+}
+
+PyIsolation GetIsolation(ClientContext &context) {
+	Value isolation;
+	if (!context.TryGetCurrentSetting("pytables_isolation", isolation) || isolation.IsNull()) {
+		return PyIsolation::NONE;
+	}
+	return ParseIsolation(isolation.GetValue<std::string>());
+}
+
+idx_t GetWorkerProcesses(ClientContext &context) {
+	Value processes;
+	if (context.TryGetCurrentSetting("pytables_worker_processes", processes) && !processes.IsNull() &&
+	    processes.GetValue<int64_t>() > 0) {
+		return processes.GetValue<int64_t>();
+	}
+	return MaxValue<idx_t>(std::thread::hardware_concurrency(), 1);
+}
+
+idx_t GetCacheTTL(ClientContext &context) {
+	Value ttl;
+	if (!context.TryGetCurrentSetting("pytables_cache_ttl", ttl) || ttl.IsNull() || ttl.GetValue<int64_t>() <= 0) {
+		return 0;
+	}
+	return ttl.GetValue<int64_t>();
+}
+
+idx_t GetCacheSize(ClientContext &context) {
+	Value size;
+	if (!context.TryGetCurrentSetting("pytables_cache_size", size) || size.IsNull()) {
+		return DBConfig::ParseMemoryLimit("256MB");
+	}
+	return DBConfig::ParseMemoryLimit(size.GetValue<std::string>());
+}
+
+idx_t GetAsyncConcurrency(ClientContext &context) {
+	Value concurrency;
+	if (!context.TryGetCurrentSetting("pytables_async_concurrency", concurrency) || concurrency.IsNull() ||
+	    concurrency.GetValue<int64_t>() < 1) {
+		return 64;
+	}
+	return concurrency.GetValue<int64_t>();
+}
+
+idx_t GetPrefetchChunks(ClientContext &context) {
+	Value chunks;
+	if (!context.TryGetCurrentSetting("pytables_prefetch_chunks", chunks) || chunks.IsNull() ||
+	    chunks.GetValue<int64_t>() <= 0) {
+		return 0;
+	}
+	return chunks.GetValue<int64_t>();
+}
+
+idx_t GetPrefetchMemory(ClientContext &context) {
+	Value memory;
+	if (!context.TryGetCurrentSetting("pytables_prefetch_memory", memory) || memory.IsNull()) {
+		return DBConfig::ParseMemoryLimit("64MB");
+	}
+	return DBConfig::ParseMemoryLimit(memory.GetValue<std::string>());
+}
+} // namespace pyudf
@@ -2,121 +2,861 @@
 #include <Python.h>
 #include <iostream>
 #include <stdexcept>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <duckdb.hpp>
 #include <duckdb/parser/expression/constant_expression.hpp>
 #include <duckdb/parser/expression/function_expression.hpp>
+#include <duckdb/common/arrow/arrow_wrapper.hpp>
+#include <duckdb/function/table/arrow.hpp>
+#include <duckdb/storage/buffer_manager.hpp>
+#include <duckdb/planner/filter/conjunction_filter.hpp>
+#include <duckdb/planner/filter/constant_filter.hpp>
+#include <duckdb/planner/table_filter.hpp>
+#include <duckdb/storage/table/column_segment.hpp>
+#include <pyasync.hpp>
+#include <pydataframe.hpp>
 #include <pytable.hpp>
+#include <pytable_cache.hpp>
+#include <pysettings.hpp>
 #include "python_function.hpp"
 #include "python_table_function.hpp"
 #include <pyconvert.hpp>
 #include <log.hpp>
+#include <cpy/gil.hpp>
 
 #include <typeinfo>
 
 using namespace duckdb;
 namespace pyudf {
 
+// Holds a struct array (or schema) whose children were picked from another one. The view points
+// into the source's children, so the source stays alive until the view is released.
+template <class T>
+struct PyArrowProjection {
+	T source;
+	std::vector<T *> children;
+
+	static void Release(T *view) {
+		auto projection = (PyArrowProjection<T> *)view->private_data;
+		if (projection->source.release) {
+			projection->source.release(&projection->source);
+		}
+		delete projection;
+		view->release = nullptr;
+	}
+};
+
+// Moves 'source' into a view exposing only the children listed in 'columns', in that order.
+template <class T>
+static void ProjectArrowChildren(T &source, const std::vector<column_t> &columns, T &out) {
+	auto projection = new PyArrowProjection<T>();
+	projection->source = source;
+	source.release = nullptr;
+	auto &moved = projection->source;
+	if (moved.n_children > 0) {
+		for (auto column : columns) {
+			// DuckDB skips row id columns without reading them, any child holds their place
+			auto child = column == COLUMN_IDENTIFIER_ROW_ID ? 0 : column;
+			projection->children.push_back(moved.children[child]);
+		}
+	}
+	out = moved;
+	out.n_children = projection->children.size();
+	out.children = projection->children.data();
+	out.private_data = projection;
+	out.release = PyArrowProjection<T>::Release;
+}
+
+// Stream over another whose batches only carry the projected columns. DuckDB's Arrow scan reads
+// output column i from child i, so producers have to do the projection themselves.
+struct PyProjectedArrowStream {
+	ArrowArrayStream source;
+	std::vector<column_t> column_ids;
+
+	static int GetSchema(ArrowArrayStream *stream, ArrowSchema *out) {
+		auto projected = (PyProjectedArrowStream *)stream->private_data;
+		ArrowSchema schema;
+		auto status = projected->source.get_schema(&projected->source, &schema);
+		if (status == 0) {
+			ProjectArrowChildren(schema, projected->column_ids, *out);
+		}
+		return status;
+	}
+
+	static int GetNext(ArrowArrayStream *stream, ArrowArray *out) {
+		auto projected = (PyProjectedArrowStream *)stream->private_data;
+		ArrowArray array;
+		auto status = projected->source.get_next(&projected->source, &array);
+		if (status != 0) {
+			return status;
+		}
+		if (!array.release) {
+			// End of the stream
+			out->release = nullptr;
+			return 0;
+		}
+		ProjectArrowChildren(array, projected->column_ids, *out);
+		return 0;
+	}
+
+	static const char *GetLastError(ArrowArrayStream *stream) {
+		auto projected = (PyProjectedArrowStream *)stream->private_data;
+		return projected->source.get_last_error(&projected->source);
+	}
+
+	static void Release(ArrowArrayStream *stream) {
+		auto projected = (PyProjectedArrowStream *)stream->private_data;
+		if (projected->source.release) {
+			projected->source.release(&projected->source);
+		}
+		delete projected;
+		stream->release = nullptr;
+	}
+};
+
+// Owns the ArrowArrayStream exported by a Python object's __arrow_c_stream__() method, and
+// hands it to DuckDB's Arrow scan machinery as a stream factory.
+struct PyArrowStreamFactory {
+	ArrowArrayStream stream;
+
+	// Columns the scan projects, set when it starts. Produce() hands back only these.
+	std::vector<column_t> column_ids;
+
+	PyArrowStreamFactory() {
+		stream.release = nullptr;
+	}
+
+	~PyArrowStreamFactory() {
+		if (stream.release) {
+			stream.release(&stream);
+		}
+	}
+
+	static unique_ptr<ArrowArrayStreamWrapper> Produce(uintptr_t factory_ptr, ArrowStreamParameters &parameters) {
+		auto factory = (PyArrowStreamFactory *)factory_ptr;
+		if (!factory->stream.release) {
+			throw InvalidInputException("Arrow stream returned by a Python function can only be scanned once");
+		}
+		auto projected = new PyProjectedArrowStream();
+		projected->source = factory->stream;
+		projected->column_ids = factory->column_ids;
+		// The projected stream is now responsible for releasing the stream
+		factory->stream.release = nullptr;
+
+		auto wrapper = make_uniq<ArrowArrayStreamWrapper>();
+		auto &stream = wrapper->arrow_array_stream;
+		stream.get_schema = PyProjectedArrowStream::GetSchema;
+		stream.get_next = PyProjectedArrowStream::GetNext;
+		stream.get_last_error = PyProjectedArrowStream::GetLastError;
+		stream.release = PyProjectedArrowStream::Release;
+		stream.private_data = projected;
+		return wrapper;
+	}
+
+	static void GetSchema(uintptr_t factory_ptr, ArrowSchemaWrapper &schema) {
+		auto factory = (PyArrowStreamFactory *)factory_ptr;
+		if (!factory->stream.release) {
+			throw InvalidInputException("Arrow stream returned by a Python function has already been consumed");
+		}
+		if (factory->stream.get_schema(&factory->stream, &schema.arrow_schema)) {
+			auto error = factory->stream.get_last_error(&factory->stream);
+			throw InvalidInputException("Failed to read the schema of an Arrow stream: " +
+			                            std::string(error ? error : "unknown error"));
+		}
+	}
+};
+
+// Releases an iterator the scan is done with. Generators are closed explicitly, so their
+// 'finally' blocks (closing connections, abandoning pagination, ...) run right away even if
+// something else still references them.
+static void CloseIterator(PyObject *iterator) {
+	if (!iterator) {
+		return;
+	}
+	if (PyObject_HasAttrString(iterator, "close")) {
+		PyObject *result = PyObject_CallMethod(iterator, "close", nullptr);
+		if (result) {
+			Py_DECREF(result);
+		} else {
+			// Nothing to report the error to at this point
+			PyErr_Clear();
+		}
+	}
+	Py_DECREF(iterator);
+}
+
+// Async iterables (such as async generators) are driven by an event loop of their own and
+// scanned like any other iterator. Takes over the reference to 'result'.
+static PyObject *IterateAsyncResult(PyObject *result) {
+	if (!IsAsyncIterable(result)) {
+		return result;
+	}
+	PyObject *iterator = IterateAsync(result);
+	Py_DECREF(result);
+	if (!iterator) {
+		PythonException error;
+		throw std::runtime_error(error.message);
+	}
+	return iterator;
+}
+
 struct PyScanBindData : public TableFunctionData {
 	// Function arguments coerced to a tuple used in Python calling semantics,
-	PyObject *arguments;
+	PyObject *arguments = nullptr;
 
 	// Keyword arguments coerced to a dict to be used in **kwarg calling semantics
-	PyObject *kwargs;
+	PyObject *kwargs = nullptr;
 
 	std::vector<LogicalType> return_types;
+	std::vector<std::string> names;
+
+	// Picked from return_types once at bind, writes values straight into the output vectors
+	std::vector<py_column_writer_t> column_writers;
+
+	// Return value of the function specified, handed over to the global state when the scan starts
+	PyObject *function_result_iterable = nullptr;
+
+	// The function is called when the scan starts rather than during bind, since it takes hints
+	// that depend on the query (such as 'columns') or is partitioned
+	bool deferred = false;
+
+	// The function takes the names of the projected columns as its 'columns' keyword argument
+	bool accepts_columns = false;
+
+	// The function takes the query's filters as its 'filters' keyword argument
+	bool accepts_filters = false;
 
-	// Return value of the function specified
-	PyObject *function_result_iterable;
+	// Maximum number of rows to scan, from the 'limit' named parameter
+	idx_t limit = DConstants::INVALID_INDEX;
 
-	pyudf::PythonTableFunction *pyfunc;
+	// The function yields batches of columns rather than rows, see ducktable(batched=True)
+	bool batched = false;
+
+	// Rows the function is expected to produce, INVALID_INDEX if unknown
+	idx_t estimated_rows = DConstants::INVALID_INDEX;
+
+	pyudf::PythonTableFunction *pyfunc = nullptr;
+
+	// List of partition descriptors when the function is partitioned, in which case it is
+	// called once per partition during the scan instead of once during bind.
+	PyObject *partitions = nullptr;
+	idx_t partition_count = 0;
+
+	// Set when the function returned an object exposing __arrow_c_stream__(), in which case
+	// the scan is delegated to DuckDB's Arrow scan using these.
+	unique_ptr<PyArrowStreamFactory> arrow_stream;
+	unique_ptr<FunctionData> arrow_bind_data;
+
+	// Set when the function returned a dataframe (__dataframe__()), which is scanned column by column
+	unique_ptr<PyDataFrame> dataframe;
+
+	// Identifies the call in the result cache, empty when its results aren't cached
+	std::string cache_key;
+	std::string cache_arguments;
+
+	// Cached rows replayed instead of calling the function
+	shared_ptr<PyTableCacheEntry> cached;
+
+	~PyScanBindData() override {
+		// DuckDB may destroy bind data on any of its threads
+		cpy::GIL gil;
+		CloseIterator(function_result_iterable);
+		Py_XDECREF(arguments);
+		Py_XDECREF(kwargs);
+		Py_XDECREF(partitions);
+		delete pyfunc;
+		arrow_stream.reset();
+		dataframe.reset();
+	}
 };
 
 struct PyScanLocalState : public LocalTableFunctionState {
 	bool done = false;
+	unique_ptr<LocalTableFunctionState> arrow_state;
+
+	// Iterator over the partition this thread is currently scanning
+	PyObject *partition_iterator = nullptr;
+
+	~PyScanLocalState() override {
+		if (partition_iterator) {
+			cpy::GIL gil;
+			CloseIterator(partition_iterator);
+		}
+	}
+};
+
+// A filter DuckDB pushed into the scan. DuckDB no longer applies it, so the scan does unless
+// the function marked every entry describing it as handled.
+struct PyPushedFilter {
+	idx_t output_column;
+	const TableFilter *filter;
+
+	// List of dicts passed to the function in 'filters', nullptr if the function doesn't take them
+	PyObject *entries = nullptr;
+
+	// Whether 'entries' describe the whole filter
+	bool complete = false;
+
+	bool handled = false;
+
+	// Needs the GIL when there are entries
+	bool Handled() {
+		if (handled || !entries || !complete) {
+			return handled;
+		}
+		handled = true;
+		for (Py_ssize_t i = 0; i < PyList_Size(entries); i++) {
+			// Borrowed references
+			PyObject *flag = PyDict_GetItemString(PyList_GetItem(entries, i), "handled");
+			handled = handled && flag && PyObject_IsTrue(flag) == 1;
+		}
+		return handled;
+	}
+};
+
+// Chunks read ahead of the scan by a thread of its own, so Python's I/O overlaps with DuckDB's
+// work on the chunks already read. The queue is bounded by the pytables_prefetch_* settings.
+struct PyPrefetcher {
+	PyPrefetcher(Allocator &allocator, vector<LogicalType> types, idx_t max_chunks, idx_t max_bytes)
+	    : allocator(allocator), types(std::move(types)), max_chunks(max_chunks), max_bytes(max_bytes) {
+	}
+
+	~PyPrefetcher() {
+		Stop();
+	}
+
+	Allocator &allocator;
+	vector<LogicalType> types;
+	idx_t max_chunks;
+	idx_t max_bytes;
+	std::thread thread;
+
+	// Blocks the reading thread while the queue is full. Returns false once the scan stopped.
+	bool WaitForRoom() {
+		std::unique_lock<std::mutex> guard(lock);
+		changed.wait(guard, [&] {
+			return stopped || chunks.empty() || (chunks.size() < max_chunks && queued_bytes < max_bytes);
+		});
+		return !stopped;
+	}
+
+	void Push(unique_ptr<DataChunk> chunk, bool exhausted) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (chunk->size() > 0) {
+				queued_bytes += ChunkSize(*chunk);
+				chunks.push_back(std::move(chunk));
+			}
+			finished = exhausted;
+		}
+		changed.notify_all();
+	}
+
+	void Fail(std::exception_ptr exception) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			error = exception;
+			finished = true;
+		}
+		changed.notify_all();
+	}
+
+	// The next chunk, waiting for it to be read if need be. Returns nullptr once the iterator
+	// is exhausted, and rethrows whatever the reading thread failed with.
+	unique_ptr<DataChunk> Pop() {
+		std::unique_lock<std::mutex> guard(lock);
+		changed.wait(guard, [&] { return !chunks.empty() || finished; });
+		if (!chunks.empty()) {
+			auto chunk = std::move(chunks.front());
+			chunks.pop_front();
+			queued_bytes -= ChunkSize(*chunk);
+			guard.unlock();
+			changed.notify_all();
+			return chunk;
+		} else if (error) {
+			std::rethrow_exception(error);
+		}
+		return nullptr;
+	}
+
+	// Waits for the reading thread to finish the chunk it's on. Must not be called with the GIL.
+	void Stop() {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopped = true;
+		}
+		changed.notify_all();
+		if (thread.joinable()) {
+			thread.join();
+		}
+	}
+
+private:
+	// Approximate memory held by a chunk: its values plus any strings too long to be inlined
+	static idx_t ChunkSize(DataChunk &chunk) {
+		idx_t size = 0;
+		for (auto &column : chunk.data) {
+			auto physical_type = column.GetType().InternalType();
+			size += GetTypeIdSize(physical_type) * chunk.size();
+			if (physical_type != PhysicalType::VARCHAR) {
+				continue;
+			}
+			UnifiedVectorFormat format;
+			column.ToUnifiedFormat(chunk.size(), format);
+			auto strings = (string_t *)format.data;
+			for (idx_t i = 0; i < chunk.size(); i++) {
+				auto idx = format.sel->get_index(i);
+				if (format.validity.RowIsValid(idx) && !strings[idx].IsInlined()) {
+					size += strings[idx].GetSize();
+				}
+			}
+		}
+		return size;
+	}
+
+	std::mutex lock;
+	std::condition_variable changed;
+	std::deque<unique_ptr<DataChunk>> chunks;
+	idx_t queued_bytes = 0;
+	bool finished = false;
+	bool stopped = false;
+	std::exception_ptr error;
 };
 
 struct PyScanGlobalState : public GlobalTableFunctionState {
 	PyScanGlobalState() : GlobalTableFunctionState() {
 	}
+
+	~PyScanGlobalState() override {
+		// Stopped before taking the GIL, which the reading thread may be waiting for
+		prefetcher.reset();
+		if (iterator || scan_kwargs || dataframe_scan) {
+			cpy::GIL gil;
+			dataframe_scan.reset();
+			CloseIterator(iterator);
+			Py_XDECREF(scan_kwargs);
+			row_keys.Release();
+			for (auto &filter : filters) {
+				Py_XDECREF(filter.entries);
+			}
+		}
+	}
+
+	unique_ptr<GlobalTableFunctionState> arrow_state;
+
+	// Iterator of an unpartitioned function
+	PyObject *iterator = nullptr;
+
+	// Keyword arguments for calls made during the scan, the user's kwargs plus any hints
+	PyObject *scan_kwargs = nullptr;
+
+	// Writer for each value of the rows the function yields (null when the value isn't
+	// projected), and the output column it is written to.
+	std::vector<py_column_writer_t> row_writers;
+	std::vector<idx_t> output_columns;
+
+	// Names of those values, for rows that are dicts, NamedTuples or dataclasses
+	PyRowKeys row_keys;
+
+	// Each item the function yields is a batch of columns filling (part of) a chunk
+	bool batched = false;
+
+	std::vector<PyPushedFilter> filters;
+
+	// Rows produced so far across all threads, for progress and to enforce the 'limit' parameter
+	std::atomic<idx_t> rows_emitted {0};
+
+	// Threads claim partitions in order from this cursor
+	std::atomic<idx_t> next_partition {0};
+	idx_t partition_count = 0;
+
+	// Rows replayed from the result cache, or recorded for it while the function is scanned.
+	// Either way every column passes through full_chunk, and the projected ones are output.
+	shared_ptr<PyTableCacheEntry> cached;
+	ColumnDataScanState cache_scan;
+	unique_ptr<ColumnDataCollection> recording;
+	shared_ptr<PyTableCache> cache;
+	idx_t cache_size = 0;
+	DataChunk full_chunk;
+	vector<column_t> column_ids;
+
+	// Reads the unpartitioned iterator ahead of the scan when pytables_prefetch_chunks is set
+	unique_ptr<PyPrefetcher> prefetcher;
+
+	// Scan of a dataframe the function returned
+	unique_ptr<PyDataFrameScan> dataframe_scan;
+
+	idx_t MaxThreads() const override {
+		if (arrow_state) {
+			return arrow_state->MaxThreads();
+		} else if (partition_count > 0) {
+			return partition_count;
+		}
+		return 1;
+	}
 };
 
-void FinalizePyTable(PyScanBindData &bind_data) {
+void FinalizePyTable(PyScanGlobalState &global_state) {
 	// Free the iterable returned by our python function call
-	Py_DECREF(bind_data.function_result_iterable);
-	bind_data.function_result_iterable = nullptr;
+	CloseIterator(global_state.iterator);
+	global_state.iterator = nullptr;
+}
 
-	// Free each entry of the arguments tuple and the tuple itself
-	Py_ssize_t size = PyTuple_Size(bind_data.arguments);
-	for (Py_ssize_t i = 0; i < size; i++) {
-		PyObject *arg = PyTuple_GetItem(bind_data.arguments, i);
-		// Traced a SegFault that is prevented by not issueing this decref. There
-		// is probably some side effect here that I'm not accounting for, and not
-		// an issue with this decref per say.
-		// Py_DECREF(arg);
+// Removes the rows failing any pushed down filter the function didn't handle itself
+static void ApplyFilters(PyScanGlobalState &global_state, DataChunk &output) {
+	if (global_state.filters.empty() || output.size() == 0) {
+		return;
+	}
+	SelectionVector sel(STANDARD_VECTOR_SIZE);
+	for (idx_t i = 0; i < output.size(); i++) {
+		sel.set_index(i, i);
+	}
+	idx_t approved = output.size();
+	for (auto &pushed : global_state.filters) {
+		if (pushed.Handled()) {
+			continue;
+		}
+		auto &vector = output.data[pushed.output_column];
+		vector.Flatten(output.size());
+		ColumnSegment::FilterSelection(sel, vector, *pushed.filter, approved, FlatVector::Validity(vector));
+	}
+	if (approved < output.size()) {
+		output.Slice(sel, approved);
 	}
 }
 
-void PyScan(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
-	auto &bind_data = (PyScanBindData &)*data.bind_data;
+// Counts the chunk's rows and cuts it off at the 'limit' parameter. Returns true once the
+// limit has been reached, after which this thread has nothing more to scan.
+static bool ApplyLimit(PyScanBindData &bind_data, PyScanGlobalState &global_state, DataChunk &output) {
+	auto emitted = global_state.rows_emitted.fetch_add(output.size());
+	if (bind_data.limit == DConstants::INVALID_INDEX) {
+		return false;
+	} else if (emitted >= bind_data.limit) {
+		output.SetCardinality(0);
+		return true;
+	} else if (emitted + output.size() >= bind_data.limit) {
+		output.SetCardinality(bind_data.limit - emitted);
+		return true;
+	}
+	return false;
+}
 
-	auto &local_state = (PyScanLocalState &)*data.local_state;
+// Appends rows from the iterator to the output until it is full, or a single non-empty batch for
+// batched functions. Returns true once the iterator is exhausted, and throws if it raised an
+// exception.
+static bool ReadRows(PyScanGlobalState &global_state, PyObject *iterator, DataChunk &output) {
+	while (output.size() < STANDARD_VECTOR_SIZE) {
+		PyObject *row = PyIter_Next(iterator);
+		if (!row) {
+			// PyIter_Next will return null if the iterator is exhausted or if an
+			// exception has occurred during resumption of the underlying function,
+			// so at this point we need to check which of these is the case.
+			if (PyErr_Occurred()) {
+				PythonException error;
+				throw std::runtime_error(error.message);
+			}
+			return true;
+		}
+		if (global_state.batched) {
+			idx_t count;
+			try {
+				count = WritePyBatch(row, global_state.row_writers, global_state.output_columns,
+				                     global_state.row_keys, output);
+			} catch (...) {
+				Py_DECREF(row);
+				throw;
+			}
+			Py_DECREF(row);
+			output.SetCardinality(output.size() + count);
+			if (count > 0) {
+				return false;
+			}
+			continue;
+		}
+		try {
+			WritePyRowObject(row, global_state.row_writers, global_state.output_columns, global_state.row_keys, output,
+			                 output.size());
+		} catch (...) {
+			Py_DECREF(row);
+			throw;
+		}
+		Py_DECREF(row);
+		output.SetCardinality(output.size() + 1);
+	}
+	return false;
+}
+
+// Calls the function for one of its partitions, which is passed as the 'partition' keyword argument
+static PyObject *OpenPartition(PyScanBindData &bind_data, PyScanGlobalState &global_state, idx_t partition) {
+	PyObject *kwargs = PyDict_Copy(global_state.scan_kwargs);
+	// Borrowed reference, the dict takes its own
+	PyDict_SetItemString(kwargs, "partition", PyList_GetItem(bind_data.partitions, partition));
+
+	PyObject *result;
+	PythonException *error;
+	std::tie(result, error) = bind_data.pyfunc->call(bind_data.arguments, kwargs);
+	Py_DECREF(kwargs);
+	if (!result) {
+		std::string err = error->message;
+		error->~PythonException();
+		throw std::runtime_error(err);
+	}
+	result = IterateAsyncResult(result);
+	PyObject *iterator = PyObject_GetIter(result);
+	Py_DECREF(result);
+	if (!iterator) {
+		PyErr_Clear();
+		throw std::runtime_error("Error: function '" + bind_data.pyfunc->function_name() +
+		                         "' did not return an iterator for partition " + std::to_string(partition));
+	}
+	return iterator;
+}
 
+// Fills the chunk from whichever partitions this thread claims, moving on to the next
+// unclaimed partition whenever the current one is exhausted.
+static void PyScanPartitions(PyScanBindData &bind_data, PyScanGlobalState &global_state,
+                             PyScanLocalState &local_state, DataChunk &output) {
+	while (!local_state.done && output.size() < STANDARD_VECTOR_SIZE) {
+		if (global_state.batched && output.size() > 0) {
+			// The next batch may need the whole chunk
+			break;
+		}
+		if (!local_state.partition_iterator) {
+			auto partition = global_state.next_partition++;
+			if (partition >= global_state.partition_count) {
+				local_state.done = true;
+				break;
+			}
+			local_state.partition_iterator = OpenPartition(bind_data, global_state, partition);
+		}
+		if (ReadRows(global_state, local_state.partition_iterator, output)) {
+			CloseIterator(local_state.partition_iterator);
+			local_state.partition_iterator = nullptr;
+		}
+	}
+}
+
+// Points the output at the projected columns of the full chunk
+static void ProjectFullChunk(PyScanGlobalState &global_state, DataChunk &output) {
+	for (idx_t i = 0; i < global_state.column_ids.size(); i++) {
+		if (global_state.column_ids[i] == COLUMN_IDENTIFIER_ROW_ID) {
+			continue;
+		}
+		output.data[i].Reference(global_state.full_chunk.data[global_state.column_ids[i]]);
+	}
+	output.SetCardinality(global_state.full_chunk.size());
+}
+
+// Reads the next rows of a cached result
+static void PyScanCached(PyScanGlobalState &global_state, PyScanLocalState &local_state, DataChunk &output) {
 	if (local_state.done) {
 		return;
 	}
+	global_state.full_chunk.Reset();
+	if (!global_state.cached->rows->Scan(global_state.cache_scan, global_state.full_chunk)) {
+		local_state.done = true;
+		return;
+	}
+	ProjectFullChunk(global_state, output);
+}
+
+// Hands the recorded rows of a scan that ran to completion to the result cache
+static void CacheResult(PyScanBindData &bind_data, PyScanGlobalState &global_state) {
+	auto entry = make_shared<PyTableCacheEntry>();
+	entry->function = bind_data.pyfunc->module_name() + ":" + bind_data.pyfunc->function_name();
+	entry->arguments = bind_data.cache_arguments;
+	entry->types = bind_data.return_types;
+	entry->names = bind_data.names;
+	entry->rows = std::move(global_state.recording);
+	entry->created = std::chrono::steady_clock::now();
+	global_state.cache->Insert(bind_data.cache_key, std::move(entry), global_state.cache_size);
+}
 
-	PyObject *result = bind_data.function_result_iterable;
+// Reads the next rows of an unpartitioned function's iterator
+static void PyScanIterator(PyScanBindData &bind_data, PyScanGlobalState &global_state, PyScanLocalState &local_state,
+                           DataChunk &output) {
+	if (local_state.done) {
+		return;
+	}
+
+	PyObject *result = global_state.iterator;
 	if (nullptr == result) {
 		throw std::runtime_error("Where did our iterator go?");
 	}
 
-	PyObject *row;
-	int read_records = 0;
-	while ((read_records < STANDARD_VECTOR_SIZE) && (row = PyIter_Next(result))) {
-		auto iter_row = pyObjectToIterable(row);
-		// todo: acquire the GIL
-		if (PyErr_Occurred()) {
-			PythonException err;
-			// todo: release the GIL
-			throw std::runtime_error(err.message);
-		}
-		// todo: release the GIL
-		else if (!iter_row) {
-			// todo: cleanup?
-			throw std::runtime_error("Error: Row record not iterable as expected");
+	bool exhausted;
+	try {
+		if (global_state.recording) {
+			global_state.full_chunk.Reset();
+			exhausted = ReadRows(global_state, result, global_state.full_chunk);
+			global_state.recording->Append(global_state.full_chunk);
+			ProjectFullChunk(global_state, output);
 		} else {
-			std::vector<duckdb::Value> duck_row = {};
-			ConvertPyObjectsToDuckDBValues(iter_row, bind_data.return_types, duck_row);
-			for (long unsigned int i = 0; i < duck_row.size(); i++) {
-				auto v = duck_row.at(i);
-				// todo: Am I doing this correctly? I have no idea.
-				output.SetValue(i, output.size(), v);
-			}
-			Py_DECREF(row);
-			output.SetCardinality(output.size() + 1);
-			read_records++;
+			exhausted = ReadRows(global_state, result, output);
 		}
-	}
-
-	// PyIter_Next will return null if the iterator is exhausted or if an
-	// exception has occurred during resumption of the underlying function,
-	// so at this point we need to check which of these is the case.
-	if (PyErr_Occurred()) {
-		PythonException error = PythonException();
-
+	} catch (...) {
 		// Shouldn't be necessary, but mark our scan as complete for good measure.
 		local_state.done = true;
 
 		// Clean everything up
-		FinalizePyTable(bind_data);
-		throw std::runtime_error(error.message);
+		FinalizePyTable(global_state);
+		throw;
+	}
+	if (exhausted) {
+		local_state.done = true;
+		FinalizePyTable(global_state);
+		if (global_state.recording) {
+			CacheResult(bind_data, global_state);
+		}
+	}
+}
+
+// Reads chunks from the iterator into the prefetch queue until it's exhausted or the scan
+// stops. Only holds the GIL while reading a chunk. Filters are applied here when possible.
+static void PrefetchRows(PyScanGlobalState &global_state) {
+	auto &prefetcher = *global_state.prefetcher;
+	try {
+		bool exhausted = false;
+		while (!exhausted && prefetcher.WaitForRoom()) {
+			auto chunk = make_uniq<DataChunk>();
+			chunk->Initialize(prefetcher.allocator, prefetcher.types);
+			{
+				cpy::GIL gil;
+				exhausted = ReadRows(global_state, global_state.iterator, *chunk);
+				if (!global_state.recording) {
+					ApplyFilters(global_state, *chunk);
+				}
+				if (exhausted) {
+					FinalizePyTable(global_state);
+				}
+			}
+			prefetcher.Push(std::move(chunk), exhausted);
+		}
+	} catch (...) {
+		{
+			cpy::GIL gil;
+			FinalizePyTable(global_state);
+		}
+		prefetcher.Fail(std::current_exception());
 	}
-	if (!row) {
-		// We've exhausted our iterator
+}
+
+// Takes the next chunk read by the prefetch thread
+static void PyScanPrefetched(PyScanBindData &bind_data, PyScanGlobalState &global_state,
+                             PyScanLocalState &local_state, DataChunk &output) {
+	if (local_state.done) {
+		return;
+	}
+	auto chunk = global_state.prefetcher->Pop();
+	if (!chunk) {
 		local_state.done = true;
-		FinalizePyTable(bind_data);
+		if (global_state.recording) {
+			CacheResult(bind_data, global_state);
+		}
+		return;
+	}
+	if (global_state.recording) {
+		global_state.recording->Append(*chunk);
+		global_state.full_chunk.Reference(*chunk);
+		ProjectFullChunk(global_state, output);
+	} else {
+		output.Reference(*chunk);
+	}
+}
+
+void PyScan(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &bind_data = (PyScanBindData &)*data.bind_data;
+
+	auto &local_state = (PyScanLocalState &)*data.local_state;
+	auto &global_state = (PyScanGlobalState &)*data.global_state;
+
+	if (local_state.arrow_state) {
+		TableFunctionInput arrow_input(bind_data.arrow_bind_data.get(), local_state.arrow_state.get(),
+		                               global_state.arrow_state.get());
+		// The stream ignores the filters it is handed, so they're applied here. An empty chunk
+		// is the end of the scan, so keep going until some rows pass.
+		if (local_state.done) {
+			return;
+		}
+		do {
+			output.Reset();
+			ArrowTableFunction::ArrowScanFunction(context, arrow_input, output);
+			if (output.size() == 0) {
+				return;
+			}
+			ApplyFilters(global_state, output);
+		} while (output.size() == 0);
+		local_state.done = ApplyLimit(bind_data, global_state, output);
+		return;
+	}
+
+	if (global_state.dataframe_scan) {
+		if (local_state.done) {
+			return;
+		}
+		cpy::GIL gil;
+		do {
+			output.Reset();
+			local_state.done = !global_state.dataframe_scan->Scan(output);
+			ApplyFilters(global_state, output);
+		} while (output.size() == 0 && !local_state.done);
+		local_state.done = ApplyLimit(bind_data, global_state, output) || local_state.done;
+		return;
+	}
+
+	if (global_state.cached) {
+		do {
+			output.Reset();
+			PyScanCached(global_state, local_state, output);
+			ApplyFilters(global_state, output);
+		} while (output.size() == 0 && !local_state.done);
+		local_state.done = ApplyLimit(bind_data, global_state, output) || local_state.done;
+		return;
+	}
+
+	if (global_state.prefetcher) {
+		do {
+			output.Reset();
+			PyScanPrefetched(bind_data, global_state, local_state, output);
+			if (global_state.recording) {
+				// Chunks are recorded for the cache unfiltered
+				ApplyFilters(global_state, output);
+			}
+		} while (output.size() == 0 && !local_state.done);
+		if (ApplyLimit(bind_data, global_state, output)) {
+			local_state.done = true;
+			global_state.prefetcher->Stop();
+			cpy::GIL gil;
+			FinalizePyTable(global_state);
+		}
 		return;
 	}
+
+	// Taken once per chunk. DuckDB runs the rest of the pipeline without it.
+	cpy::GIL gil;
+	do {
+		output.Reset();
+		if (bind_data.partitions) {
+			PyScanPartitions(bind_data, global_state, local_state, output);
+		} else {
+			PyScanIterator(bind_data, global_state, local_state, output);
+		}
+		ApplyFilters(global_state, output);
+		if (ApplyLimit(bind_data, global_state, output)) {
+			// Stop pulling from Python right away instead of when the query finishes
+			local_state.done = true;
+			CloseIterator(local_state.partition_iterator);
+			local_state.partition_iterator = nullptr;
+			if (!bind_data.partitions) {
+				FinalizePyTable(global_state);
+			}
+		}
+	} while (output.size() == 0 && !local_state.done);
 }
 
 void PyBindFunctionAndArgs(ClientContext &context, TableFunctionBindInput &input,
@@ -164,6 +904,66 @@ void PyBindFunctionAndArgs(ClientContext &context, TableFunctionBindInput &input
 		}
 		bind_data->kwargs = duckdb_to_py(input_kwargs);
 	}
+
+	if (0 < params.count("limit") && !params["limit"].IsNull()) {
+		auto limit = params["limit"].GetValue<int64_t>();
+		if (limit < 0) {
+			throw InvalidInputException("limit must not be negative");
+		}
+		bind_data->limit = limit;
+	}
+}
+
+// Looks the call up in the result cache when it is enabled, keyed on everything passed to
+// pytable. Returns true on a hit, in which case the function isn't called at all.
+bool PyBindCached(ClientContext &context, TableFunctionBindInput &input, unique_ptr<PyScanBindData> &bind_data,
+                  std::vector<LogicalType> &return_types, std::vector<std::string> &names) {
+	auto ttl = GetCacheTTL(context);
+	if (ttl == 0) {
+		return false;
+	}
+	std::vector<std::string> arguments;
+	for (auto &value : input.inputs) {
+		arguments.push_back(value.ToSQLString());
+	}
+	// Sorted so the key doesn't depend on the order the parameters were written in
+	std::map<std::string, std::string> named_parameters;
+	for (auto &param : input.named_parameters) {
+		named_parameters[param.first] = param.second.ToSQLString();
+	}
+	for (auto &param : named_parameters) {
+		arguments.push_back(param.first + " := " + param.second);
+	}
+	bind_data->cache_arguments = StringUtil::Join(arguments, ", ");
+	bind_data->cache_key = bind_data->pyfunc->module_name() + ":" + bind_data->pyfunc->function_name() + "(" +
+	                       bind_data->cache_arguments + ")";
+
+	auto entry = PyTableCache::Get(context)->Lookup(bind_data->cache_key, ttl);
+	if (!entry) {
+		return false;
+	}
+	debug("Replaying cached result of " + bind_data->cache_key);
+	return_types = entry->types;
+	names = entry->names;
+	bind_data->return_types = entry->types;
+	bind_data->names = entry->names;
+	bind_data->estimated_rows = entry->rows->Count();
+	bind_data->cached = std::move(entry);
+	return true;
+}
+
+// Passes the 'limit' parameter on to functions that take a 'limit' keyword argument, so they
+// can fetch no more than that. Done after listing partitions, which don't get it.
+void PyBindLimitHint(unique_ptr<PyScanBindData> &bind_data) {
+	if (bind_data->limit == DConstants::INVALID_INDEX || !bind_data->pyfunc->accepts_keyword("limit")) {
+		return;
+	}
+	if (!bind_data->kwargs) {
+		bind_data->kwargs = PyDict_New();
+	}
+	PyObject *limit = PyLong_FromUnsignedLongLong(bind_data->limit);
+	PyDict_SetItemString(bind_data->kwargs, "limit", limit);
+	Py_DECREF(limit);
 }
 
 void PyBindColumnsAndTypes(ClientContext &context, TableFunctionBindInput &input, unique_ptr<PyScanBindData> &bind_data,
@@ -224,13 +1024,125 @@ void PyBindColumnsAndTypes(ClientContext &context, TableFunctionBindInput &input
 	bind_data->return_types = std::vector<LogicalType>(return_types);
 }
 
+// Takes ownership of the ArrowArrayStream behind an object implementing the Arrow PyCapsule
+// interface, and binds an Arrow scan over it. The schema always comes from the stream.
+void PyBindArrowStream(ClientContext &context, PyObject *arrow_obj, unique_ptr<PyScanBindData> &bind_data,
+                       std::vector<LogicalType> &return_types, std::vector<std::string> &names) {
+	PyObject *capsule = PyObject_CallMethod(arrow_obj, "__arrow_c_stream__", nullptr);
+	if (!capsule) {
+		PythonException error;
+		throw std::runtime_error(error.message);
+	}
+	auto stream = (ArrowArrayStream *)PyCapsule_GetPointer(capsule, "arrow_array_stream");
+	if (!stream) {
+		Py_DECREF(capsule);
+		PythonException error;
+		throw InvalidInputException("__arrow_c_stream__() did not return an Arrow stream capsule: " + error.message);
+	}
+	// Move the stream out of the capsule, marking the capsule's copy as released so its
+	// destructor leaves the stream alone.
+	bind_data->arrow_stream = make_uniq<PyArrowStreamFactory>();
+	bind_data->arrow_stream->stream = *stream;
+	stream->release = nullptr;
+	Py_DECREF(capsule);
+
+	vector<Value> arrow_inputs = {Value::POINTER((uintptr_t)bind_data->arrow_stream.get()),
+	                              Value::POINTER((uintptr_t)&PyArrowStreamFactory::Produce),
+	                              Value::POINTER((uintptr_t)&PyArrowStreamFactory::GetSchema)};
+	named_parameter_map_t arrow_named_parameters;
+	vector<LogicalType> input_table_types;
+	vector<string> input_table_names;
+	TableFunctionBindInput arrow_input(arrow_inputs, arrow_named_parameters, input_table_types, input_table_names,
+	                                   nullptr);
+	bind_data->arrow_bind_data = ArrowTableFunction::ArrowScanBind(context, arrow_input, return_types, names);
+	bind_data->return_types = return_types;
+}
+
+// Objects implementing both __arrow_c_stream__() and __dataframe__() are read as Arrow when they
+// come from pyarrow, and as dataframes otherwise (pandas needs pyarrow for its Arrow stream).
+static bool PreferArrowStream(PyObject *result) {
+	if (!PyObject_HasAttrString(result, "__arrow_c_stream__")) {
+		return false;
+	} else if (!IsPyDataFrame(result)) {
+		return true;
+	}
+	PyObject *module = PyObject_GetAttrString((PyObject *)Py_TYPE(result), "__module__");
+	PyObject *prefix = PyUnicode_FromString("pyarrow");
+	bool from_pyarrow =
+	    module && PyUnicode_Check(module) && PyUnicode_Tailmatch(module, prefix, 0, PY_SSIZE_T_MAX, -1) == 1;
+	Py_XDECREF(module);
+	Py_DECREF(prefix);
+	PyErr_Clear();
+	return from_pyarrow;
+}
+
+// Takes the columns of a dataframe from its dtypes, like an Arrow result's from its schema
+static void PyBindDataFrame(PyObject *result, unique_ptr<PyScanBindData> &bind_data,
+                            std::vector<LogicalType> &return_types, std::vector<std::string> &names) {
+	bind_data->dataframe = make_uniq<PyDataFrame>(result);
+	for (auto &column : bind_data->dataframe->columns) {
+		names.push_back(column.name);
+		return_types.push_back(column.type);
+	}
+	bind_data->names = names;
+	bind_data->return_types = return_types;
+	if (bind_data->dataframe->row_count != DConstants::INVALID_INDEX) {
+		bind_data->estimated_rows = bind_data->dataframe->row_count;
+	}
+}
+
+// Row estimate from the wrapper's estimated_rows(), or failing that from the length of what
+// the function returned (a list, a pyarrow Table, ...) or its __length_hint__.
+static idx_t PyEstimateRows(PyScanBindData &bind_data, PyObject *result) {
+	auto estimate = bind_data.pyfunc->estimated_rows(bind_data.arguments, bind_data.kwargs);
+	if (estimate < 0 && result) {
+		estimate = PyObject_Size(result);
+		if (estimate < 0) {
+			PyErr_Clear();
+		}
+	}
+	if (estimate < 0 && result && PyObject_HasAttrString(result, "__length_hint__")) {
+		PyObject *hint = PyObject_CallMethod(result, "__length_hint__", nullptr);
+		if (hint && PyLong_Check(hint)) {
+			estimate = PyLong_AsLongLong(hint);
+		}
+		Py_XDECREF(hint);
+		if (PyErr_Occurred() || estimate < 0) {
+			PyErr_Clear();
+			estimate = -1;
+		}
+	}
+	return estimate < 0 ? DConstants::INVALID_INDEX : estimate;
+}
+
 unique_ptr<FunctionData> PyBind(ClientContext &context, TableFunctionBindInput &input,
                                 std::vector<LogicalType> &return_types, std::vector<std::string> &names) {
+	cpy::GIL gil;
 	auto result = make_uniq<PyScanBindData>();
 	PyBindFunctionAndArgs(context, input, result);
-	PyBindColumnsAndTypes(context, input, result, return_types, names);
-	debug("PyBindColumnsAndTypes: Num Column Names:" + to_string(names.size()));
-	debug("PyBindColumnsAndTypes: Num Column types:" + to_string(return_types.size()));
+	result->batched = result->pyfunc->has_flag("pytables_batched");
+	if (PyBindCached(context, input, result, return_types, names)) {
+		return std::move(result);
+	}
+
+	// Partitioned functions are called once per partition by the threads scanning them, and
+	// functions taking hints are called once the query's hints are known. Either way their
+	// columns have to be known without calling the function.
+	result->partitions = result->pyfunc->partitions(result->arguments, result->kwargs);
+	result->accepts_columns = result->pyfunc->accepts_keyword("columns");
+	result->accepts_filters = result->pyfunc->accepts_keyword("filters");
+	PyBindLimitHint(result);
+	if (result->partitions || result->accepts_columns || result->accepts_filters) {
+		// What these produce depends on the query, so their results aren't cached
+		result->cache_key.clear();
+		result->deferred = true;
+		result->partition_count = result->partitions ? PyList_Size(result->partitions) : 0;
+		result->estimated_rows = PyEstimateRows(*result, nullptr);
+		PyBindColumnsAndTypes(context, input, result, return_types, names);
+		result->names = names;
+		result->column_writers = GetColumnWriters(result->return_types);
+		return std::move(result);
+	}
 
 	// Invoke the function and grab a copy of the iterable it returns.
 	PyObject *iter;
@@ -240,7 +1152,51 @@ unique_ptr<FunctionData> PyBind(ClientContext &context, TableFunctionBindInput &
 		std::string err = error->message;
 		error->~PythonException();
 		throw std::runtime_error(err);
-	} else if (!PyIter_Check(iter)) {
+	}
+
+	result->estimated_rows = PyEstimateRows(*result, iter);
+
+	// Arrow results (pyarrow Tables, RecordBatchReaders, ...) are scanned column-wise by
+	// DuckDB's Arrow scan instead of row by row.
+	if (PreferArrowStream(iter)) {
+		debug("Function returned an Arrow stream, columns are taken from its schema");
+		try {
+			PyBindArrowStream(context, iter, result, return_types, names);
+		} catch (...) {
+			Py_DECREF(iter);
+			throw;
+		}
+		Py_DECREF(iter);
+		result->function_result_iterable = nullptr;
+		result->cache_key.clear();
+		return std::move(result);
+	}
+	if (IsPyDataFrame(iter)) {
+		debug("Function returned a dataframe, columns are taken from its dtypes");
+		try {
+			PyBindDataFrame(iter, result, return_types, names);
+		} catch (...) {
+			Py_DECREF(iter);
+			throw;
+		}
+		Py_DECREF(iter);
+		result->cache_key.clear();
+		return std::move(result);
+	}
+
+	try {
+		PyBindColumnsAndTypes(context, input, result, return_types, names);
+	} catch (...) {
+		Py_DECREF(iter);
+		throw;
+	}
+	iter = IterateAsyncResult(iter);
+	debug("PyBindColumnsAndTypes: Num Column Names:" + to_string(names.size()));
+	debug("PyBindColumnsAndTypes: Num Column types:" + to_string(return_types.size()));
+	result->names = names;
+	result->column_writers = GetColumnWriters(result->return_types);
+
+	if (!PyIter_Check(iter)) {
 		Py_DECREF(iter);
 		throw std::runtime_error("Error: function '" + result->pyfunc->function_name() +
 		                         "' did not return an iterator\n");
@@ -249,22 +1205,293 @@ unique_ptr<FunctionData> PyBind(ClientContext &context, TableFunctionBindInput &
 	return std::move(result);
 }
 
+// Works out which values of each row the scan needs and which output column they go to.
+// Functions taking 'columns' yield just the projected columns, in the order they're requested.
+static void PyProjectColumns(PyScanBindData &bind_data, const vector<column_t> &column_ids,
+                             PyScanGlobalState &global_state, PyObject *scan_kwargs) {
+	if (bind_data.accepts_columns) {
+		PyObject *names = PyList_New(0);
+		for (idx_t i = 0; i < column_ids.size(); i++) {
+			if (column_ids[i] == COLUMN_IDENTIFIER_ROW_ID) {
+				continue;
+			}
+			global_state.row_writers.push_back(bind_data.column_writers[column_ids[i]]);
+			global_state.output_columns.push_back(i);
+			global_state.row_keys.Append(bind_data.names[column_ids[i]]);
+			PyObject *name = PyUnicode_FromString(bind_data.names[column_ids[i]].c_str());
+			PyList_Append(names, name);
+			Py_DECREF(name);
+		}
+		PyDict_SetItemString(scan_kwargs, "columns", names);
+		Py_DECREF(names);
+		return;
+	}
+	global_state.row_writers.assign(bind_data.column_writers.size(), nullptr);
+	global_state.output_columns.assign(bind_data.column_writers.size(), DConstants::INVALID_INDEX);
+	for (auto &name : bind_data.names) {
+		global_state.row_keys.Append(name);
+	}
+	for (idx_t i = 0; i < column_ids.size(); i++) {
+		if (column_ids[i] == COLUMN_IDENTIFIER_ROW_ID) {
+			continue;
+		}
+		global_state.row_writers[column_ids[i]] = bind_data.column_writers[column_ids[i]];
+		global_state.output_columns[column_ids[i]] = i;
+	}
+}
+
+static const char *FilterOperator(ExpressionType comparison_type) {
+	switch (comparison_type) {
+	case ExpressionType::COMPARE_EQUAL:
+		return "=";
+	case ExpressionType::COMPARE_NOTEQUAL:
+		return "!=";
+	case ExpressionType::COMPARE_LESSTHAN:
+		return "<";
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		return "<=";
+	case ExpressionType::COMPARE_GREATERTHAN:
+		return ">";
+	case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		return ">=";
+	default:
+		return nullptr;
+	}
+}
+
+static void AppendFilterEntry(PyObject *entries, const std::string &column, const char *op, const char *value_key,
+                              PyObject *value) {
+	PyObject *entry = PyDict_New();
+	PyObject *column_obj = PyUnicode_FromString(column.c_str());
+	PyObject *op_obj = PyUnicode_FromString(op);
+	PyDict_SetItemString(entry, "column", column_obj);
+	PyDict_SetItemString(entry, "op", op_obj);
+	if (value) {
+		PyDict_SetItemString(entry, value_key, value);
+		Py_DECREF(value);
+	}
+	PyList_Append(entries, entry);
+	Py_DECREF(column_obj);
+	Py_DECREF(op_obj);
+	Py_DECREF(entry);
+}
+
+// Appends dicts describing a DuckDB filter on 'column' to 'entries': constant comparisons,
+// IS [NOT] NULL, and ORs of equalities as 'in'. Returns false if some part of the filter
+// couldn't be described, in which case the entries only narrow down what it accepts.
+static bool DescribeFilter(const std::string &column, const TableFilter &filter, PyObject *entries) {
+	switch (filter.filter_type) {
+	case TableFilterType::CONSTANT_COMPARISON: {
+		auto &constant_filter = (const ConstantFilter &)filter;
+		auto op = FilterOperator(constant_filter.comparison_type);
+		if (!op) {
+			return false;
+		}
+		Value constant = constant_filter.constant;
+		AppendFilterEntry(entries, column, op, "value", duckdb_to_py(constant));
+		return true;
+	}
+	case TableFilterType::IS_NULL:
+		AppendFilterEntry(entries, column, "is_null", nullptr, nullptr);
+		return true;
+	case TableFilterType::IS_NOT_NULL:
+		AppendFilterEntry(entries, column, "is_not_null", nullptr, nullptr);
+		return true;
+	case TableFilterType::CONJUNCTION_AND: {
+		auto &conjunction = (const ConjunctionAndFilter &)filter;
+		bool complete = true;
+		for (auto &child : conjunction.child_filters) {
+			complete = DescribeFilter(column, *child, entries) && complete;
+		}
+		return complete;
+	}
+	case TableFilterType::CONJUNCTION_OR: {
+		auto &conjunction = (const ConjunctionOrFilter &)filter;
+		PyObject *values = PyList_New(0);
+		for (auto &child : conjunction.child_filters) {
+			auto &constant_filter = (const ConstantFilter &)*child;
+			if (child->filter_type != TableFilterType::CONSTANT_COMPARISON ||
+			    constant_filter.comparison_type != ExpressionType::COMPARE_EQUAL) {
+				Py_DECREF(values);
+				return false;
+			}
+			Value constant = constant_filter.constant;
+			PyObject *value = duckdb_to_py(constant);
+			PyList_Append(values, value);
+			Py_DECREF(value);
+		}
+		AppendFilterEntry(entries, column, "in", "values", values);
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+// Collects the filters DuckDB pushed into the scan. Functions taking 'filters' get them as a
+// list of dicts, and may set 'handled' on the ones they apply themselves.
+static void PyPushFilters(PyScanBindData &bind_data, TableFunctionInitInput &input, PyScanGlobalState &global_state,
+                          PyObject *scan_kwargs) {
+	if (!input.filters) {
+		return;
+	}
+	PyObject *filters = bind_data.accepts_filters ? PyList_New(0) : nullptr;
+	for (auto &entry : input.filters->filters) {
+		PyPushedFilter pushed;
+		pushed.output_column = entry.first;
+		pushed.filter = entry.second.get();
+		if (filters) {
+			auto &column = bind_data.names[input.column_ids[entry.first]];
+			pushed.entries = PyList_New(0);
+			pushed.complete = DescribeFilter(column, *entry.second, pushed.entries);
+			for (Py_ssize_t i = 0; i < PyList_Size(pushed.entries); i++) {
+				PyList_Append(filters, PyList_GetItem(pushed.entries, i));
+			}
+		}
+		global_state.filters.push_back(pushed);
+	}
+	if (filters) {
+		PyDict_SetItemString(scan_kwargs, "filters", filters);
+		Py_DECREF(filters);
+	}
+}
+
+// Starts reading the iterator on a thread of its own when pytables_prefetch_chunks is set
+static void PyStartPrefetch(ClientContext &context, PyScanBindData &bind_data, TableFunctionInitInput &input,
+                            PyScanGlobalState &global_state) {
+	auto max_chunks = GetPrefetchChunks(context);
+	if (max_chunks == 0) {
+		return;
+	}
+	// Chunks are read in the layout the scan consumes them in
+	vector<LogicalType> types;
+	if (global_state.recording) {
+		types = bind_data.return_types;
+	} else {
+		for (auto column_id : input.column_ids) {
+			types.push_back(column_id == COLUMN_IDENTIFIER_ROW_ID ? LogicalType::ROW_TYPE
+			                                                       : bind_data.return_types[column_id]);
+		}
+	}
+	global_state.prefetcher =
+	    make_uniq<PyPrefetcher>(Allocator::Get(context), std::move(types), max_chunks, GetPrefetchMemory(context));
+	global_state.prefetcher->thread = std::thread(PrefetchRows, std::ref(global_state));
+}
+
 unique_ptr<GlobalTableFunctionState> PyInitGlobalState(ClientContext &context, TableFunctionInitInput &input) {
+	auto &bind_data = (PyScanBindData &)*input.bind_data;
 	auto result = make_uniq<PyScanGlobalState>();
-	// result.function = get_python_function()
+	if (bind_data.arrow_bind_data) {
+		bind_data.arrow_stream->column_ids = input.column_ids;
+		TableFunctionInitInput arrow_input(bind_data.arrow_bind_data.get(), input.column_ids, input.projection_ids,
+		                                   input.filters);
+		result->arrow_state = ArrowTableFunction::ArrowScanInitGlobal(context, arrow_input);
+		PyPushFilters(bind_data, input, *result, nullptr);
+		return std::move(result);
+	}
+	result->partition_count = bind_data.partition_count;
+	result->batched = bind_data.batched;
+	if (bind_data.dataframe) {
+		cpy::GIL gil;
+		result->dataframe_scan = make_uniq<PyDataFrameScan>(*bind_data.dataframe, input.column_ids);
+		PyPushFilters(bind_data, input, *result, nullptr);
+		return std::move(result);
+	}
+	if (bind_data.cached) {
+		result->cached = bind_data.cached;
+		result->cached->rows->InitializeScan(result->cache_scan);
+		result->column_ids = input.column_ids;
+		result->full_chunk.Initialize(Allocator::Get(context), bind_data.return_types);
+		PyPushFilters(bind_data, input, *result, nullptr);
+		return std::move(result);
+	}
+
+	cpy::GIL gil;
+	result->scan_kwargs = bind_data.kwargs ? PyDict_Copy(bind_data.kwargs) : PyDict_New();
+	PyProjectColumns(bind_data, input.column_ids, *result, result->scan_kwargs);
+	PyPushFilters(bind_data, input, *result, result->scan_kwargs);
+	if (!bind_data.cache_key.empty() && bind_data.function_result_iterable) {
+		// Every column is recorded for the cache, whatever this query projects
+		result->row_writers = bind_data.column_writers;
+		result->output_columns.clear();
+		for (idx_t i = 0; i < bind_data.column_writers.size(); i++) {
+			result->output_columns.push_back(i);
+		}
+		result->column_ids = input.column_ids;
+		result->full_chunk.Initialize(Allocator::Get(context), bind_data.return_types);
+		result->recording =
+		    make_uniq<ColumnDataCollection>(BufferManager::GetBufferManager(context), bind_data.return_types);
+		result->cache = PyTableCache::Get(context);
+		result->cache_size = GetCacheSize(context);
+	}
+	if (bind_data.partitions) {
+		return std::move(result);
+	}
+	if (!bind_data.deferred) {
+		// Called during bind, the scan takes over the iterator
+		result->iterator = bind_data.function_result_iterable;
+		bind_data.function_result_iterable = nullptr;
+		PyStartPrefetch(context, bind_data, input, *result);
+		return std::move(result);
+	}
+
+	PyObject *iter;
+	PythonException *error;
+	std::tie(iter, error) = bind_data.pyfunc->call(bind_data.arguments, result->scan_kwargs);
+	if (!iter) {
+		std::string err = error->message;
+		error->~PythonException();
+		throw std::runtime_error(err);
+	}
+	iter = IterateAsyncResult(iter);
+	if (!PyIter_Check(iter)) {
+		Py_DECREF(iter);
+		throw std::runtime_error("Error: function '" + bind_data.pyfunc->function_name() +
+		                         "' did not return an iterator\n");
+	}
+	result->iterator = iter;
+	PyStartPrefetch(context, bind_data, input, *result);
 	return std::move(result);
 }
 
 unique_ptr<LocalTableFunctionState> PyInitLocalState(ExecutionContext &context, TableFunctionInitInput &input,
                                                      GlobalTableFunctionState *global_state) {
-	// Leaving tehese commented out in case we need them in the future.
-	// auto bind_data = (const PyScanBindData *)input.bind_data;
-	// auto &gstate = (PyScanGlobalState &)*global_state;
+	auto &bind_data = (const PyScanBindData &)*input.bind_data;
+	auto &gstate = (PyScanGlobalState &)*global_state;
 	auto local_state = make_uniq<PyScanLocalState>();
+	if (gstate.arrow_state) {
+		TableFunctionInitInput arrow_input(bind_data.arrow_bind_data.get(), input.column_ids, input.projection_ids,
+		                                   input.filters);
+		local_state->arrow_state = ArrowTableFunction::ArrowScanInitLocal(context, arrow_input, gstate.arrow_state.get());
+	}
 
 	return std::move(local_state);
 }
 
+unique_ptr<NodeStatistics> PyCardinality(ClientContext &context, const FunctionData *bind_data_p) {
+	auto &bind_data = (const PyScanBindData &)*bind_data_p;
+	if (bind_data.estimated_rows == DConstants::INVALID_INDEX) {
+		if (bind_data.limit != DConstants::INVALID_INDEX) {
+			return make_uniq<NodeStatistics>(bind_data.limit, bind_data.limit);
+		}
+		return make_uniq<NodeStatistics>();
+	}
+	auto estimate = MinValue(bind_data.estimated_rows, bind_data.limit);
+	return make_uniq<NodeStatistics>(estimate);
+}
+
+double PyProgress(ClientContext &context, const FunctionData *bind_data_p, const GlobalTableFunctionState *global_p) {
+	auto &bind_data = (const PyScanBindData &)*bind_data_p;
+	auto &global_state = (const PyScanGlobalState &)*global_p;
+	auto expected = MinValue(bind_data.estimated_rows, bind_data.limit);
+	if (expected == DConstants::INVALID_INDEX) {
+		return -1;
+	} else if (expected == 0) {
+		return 100;
+	}
+	return MinValue(100.0, 100.0 * global_state.rows_emitted / expected);
+}
+
 unique_ptr<CreateTableFunctionInfo> GetPythonTableFunction() {
 	auto py_table_function = duckdb::TableFunction("pytable", {}, PyScan, (table_function_bind_t)PyBind,
 	                                               PyInitGlobalState, PyInitLocalState);
@@ -276,6 +1503,19 @@ unique_ptr<CreateTableFunctionInfo> GetPythonTableFunction() {
 	py_table_function.named_parameters["func"] = LogicalType::VARCHAR;
 	py_table_function.named_parameters["columns"] = LogicalType::ANY;
 	py_table_function.named_parameters["kwargs"] = LogicalType::ANY;
+	py_table_function.named_parameters["limit"] = LogicalType::BIGINT;
+
+	// Only the projected columns are written, and passed to functions that take 'columns'. Arrow
+	// streams are projected before they reach DuckDB's Arrow scan, see PyProjectedArrowStream.
+	py_table_function.projection_pushdown = true;
+
+	// Filters are described to functions that take 'filters', and applied by the scan unless
+	// the function handles them
+	py_table_function.filter_pushdown = true;
+
+	// Row estimates from the function's estimator or the length of what it returned
+	py_table_function.cardinality = PyCardinality;
+	py_table_function.table_scan_progress = PyProgress;
 
 	CreateTableFunctionInfo py_table_function_info(py_table_function);
 	return make_uniq<CreateTableFunctionInfo>(py_table_function_info);
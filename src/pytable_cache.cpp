@@ -0,0 +1,144 @@
+#include <duckdb.hpp>
+#include <duckdb/function/scalar_function.hpp>
+#include <duckdb/function/table_function.hpp>
+#include <pytable_cache.hpp>
+
+using namespace duckdb;
+namespace pyudf {
+
+double PyTableCacheEntry::AgeSeconds() const {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - created).count();
+}
+
+shared_ptr<PyTableCache> PyTableCache::Get(ClientContext &context) {
+	return ObjectCache::GetObjectCache(context).GetOrCreate<PyTableCache>(ObjectType());
+}
+
+shared_ptr<PyTableCacheEntry> PyTableCache::Lookup(const std::string &key, idx_t ttl) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto entry = entries.find(key);
+	if (entry == entries.end()) {
+		return nullptr;
+	}
+	if (entry->second->AgeSeconds() >= ttl) {
+		entries.erase(entry);
+		return nullptr;
+	}
+	entry->second->hits++;
+	return entry->second;
+}
+
+void PyTableCache::Insert(const std::string &key, shared_ptr<PyTableCacheEntry> entry, idx_t max_size) {
+	auto size = entry->rows->SizeInBytes();
+	if (size > max_size) {
+		return;
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	entries[key] = std::move(entry);
+
+	idx_t total = 0;
+	for (auto &cached : entries) {
+		total += cached.second->rows->SizeInBytes();
+	}
+	while (total > max_size) {
+		auto oldest = entries.begin();
+		for (auto it = entries.begin(); it != entries.end(); it++) {
+			if (it->second->created < oldest->second->created) {
+				oldest = it;
+			}
+		}
+		total -= oldest->second->rows->SizeInBytes();
+		entries.erase(oldest);
+	}
+}
+
+idx_t PyTableCache::Evict(const std::string &function) {
+	std::lock_guard<std::mutex> guard(lock);
+	idx_t evicted = 0;
+	for (auto it = entries.begin(); it != entries.end();) {
+		if (function.empty() || it->second->function == function) {
+			it = entries.erase(it);
+			evicted++;
+		} else {
+			it++;
+		}
+	}
+	return evicted;
+}
+
+std::vector<shared_ptr<PyTableCacheEntry>> PyTableCache::Entries() {
+	std::lock_guard<std::mutex> guard(lock);
+	std::vector<shared_ptr<PyTableCacheEntry>> result;
+	for (auto &entry : entries) {
+		result.push_back(entry.second);
+	}
+	return result;
+}
+
+struct PyTableCacheScanState : public GlobalTableFunctionState {
+	std::vector<shared_ptr<PyTableCacheEntry>> entries;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> PyTableCacheBind(ClientContext &context, TableFunctionBindInput &input,
+                                                 vector<LogicalType> &return_types, vector<string> &names) {
+	names = {"function", "arguments", "row_count", "size_bytes", "age_seconds", "hits"};
+	return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::BIGINT,
+	                LogicalType::BIGINT,  LogicalType::DOUBLE,  LogicalType::BIGINT};
+	return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> PyTableCacheInit(ClientContext &context, TableFunctionInitInput &input) {
+	auto state = make_uniq<PyTableCacheScanState>();
+	state->entries = PyTableCache::Get(context)->Entries();
+	return std::move(state);
+}
+
+static void PyTableCacheScan(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &state = (PyTableCacheScanState &)*data.global_state;
+	idx_t row = 0;
+	for (; state.offset < state.entries.size() && row < STANDARD_VECTOR_SIZE; state.offset++, row++) {
+		auto &entry = *state.entries[state.offset];
+		output.SetValue(0, row, Value(entry.function));
+		output.SetValue(1, row, Value(entry.arguments));
+		output.SetValue(2, row, Value::BIGINT(entry.rows->Count()));
+		output.SetValue(3, row, Value::BIGINT(entry.rows->SizeInBytes()));
+		output.SetValue(4, row, Value::DOUBLE(entry.AgeSeconds()));
+		output.SetValue(5, row, Value::BIGINT(entry.hits));
+	}
+	output.SetCardinality(row);
+}
+
+unique_ptr<CreateTableFunctionInfo> GetPyTableCacheFunction() {
+	TableFunction cache_function("pytables_cache", {}, PyTableCacheScan, PyTableCacheBind, PyTableCacheInit);
+	return make_uniq<CreateTableFunctionInfo>(cache_function);
+}
+
+static void PyTableCacheClear(DataChunk &args, ExpressionState &state, Vector &result) {
+	auto cache = PyTableCache::Get(state.GetContext());
+	auto results = FlatVector::GetData<int64_t>(result);
+	for (idx_t row = 0; row < args.size(); row++) {
+		std::string function;
+		if (args.ColumnCount() > 0) {
+			auto value = args.data[0].GetValue(row);
+			if (value.IsNull()) {
+				FlatVector::SetNull(result, row, true);
+				continue;
+			}
+			function = value.GetValue<std::string>();
+		}
+		results[row] = cache->Evict(function);
+	}
+}
+
+CreateScalarFunctionInfo GetPyTableCacheClearFunction() {
+	ScalarFunctionSet clear_functions("pytables_cache_clear");
+	ScalarFunction clear_all({}, LogicalType::BIGINT, PyTableCacheClear);
+	clear_all.side_effects = FunctionSideEffects::HAS_SIDE_EFFECTS;
+	clear_functions.AddFunction(clear_all);
+	ScalarFunction clear_function({LogicalType::VARCHAR}, LogicalType::BIGINT, PyTableCacheClear);
+	clear_function.side_effects = FunctionSideEffects::HAS_SIDE_EFFECTS;
+	clear_functions.AddFunction(clear_function);
+	return CreateScalarFunctionInfo(clear_functions);
+}
+} // namespace pyudf
@@ -5,7 +5,10 @@
 #include "config.h"
 #include <Python.h>
 #include "pyscalar.hpp"
+#include "pymemo.hpp"
 #include "pytable.hpp"
+#include "pytable_cache.hpp"
+#include "pysettings.hpp"
 #include "pytables_extension.hpp"
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
@@ -28,12 +31,32 @@ static void LoadInternal(DatabaseInstance &instance) {
 	// pytables_fun_info.on_conflict = OnCreateConflict::ALTER_ON_CONFLICT;
 	catalog.CreateFunction(*con.context, python_scalar);
 
+	auto python_vectorized_scalar = pyudf::GetPythonVectorizedScalarFunction();
+	catalog.CreateFunction(*con.context, python_vectorized_scalar);
+
 	// pyudf::GetPythonTableFunction();
 	auto python_table = pyudf::GetPythonTableFunction();
 	catalog.CreateTableFunction(context, python_table.get());
 
-	// Initialize the Python interpreter
-	Py_Initialize();
+	auto cache_table = pyudf::GetPyTableCacheFunction();
+	catalog.CreateTableFunction(context, cache_table.get());
+
+	auto cache_clear = pyudf::GetPyTableCacheClearFunction();
+	catalog.CreateFunction(context, cache_clear);
+
+	auto memo_stats = pyudf::GetPyMemoStatsFunction();
+	catalog.CreateTableFunction(context, memo_stats.get());
+
+	pyudf::RegisterSettings(DBConfig::GetConfig(instance));
+
+	// Initialize the Python interpreter, unless we're loaded into a process that already has
+	// one (such as DuckDB's own Python package). Py_Initialize() leaves this thread holding
+	// the GIL, which we release right away: every Python section acquires it for itself, so
+	// our functions can run on any of DuckDB's threads.
+	if (!Py_IsInitialized()) {
+		Py_Initialize();
+		PyEval_SaveThread();
+	}
 
 	// Python C Extensions will encounter errors about missing symbols unless
 	// we eplicitly load the entire contents of the shared library. We do this
@@ -1,6 +1,7 @@
 #include <duckdb.hpp>
 #include <python_function.hpp>
 #include <python_exception.hpp>
+#include <cpy/gil.hpp>
 #include <stdexcept>
 #include <typeinfo>
 
@@ -44,6 +45,8 @@ void PythonFunction::init(const std::string &module_name, const std::string &fun
 }
 
 PythonFunction::~PythonFunction() {
+	// Functions are cached in bind data and expression states, which DuckDB may destroy on any thread
+	cpy::GIL gil;
 	Py_DECREF(function);
 	Py_DECREF(module);
 }
@@ -70,6 +73,59 @@ std::pair<PyObject *, PythonException *> PythonFunction::call(PyObject *args) co
 	}
 }
 
+bool PythonFunction::has_flag(const std::string &attr_name) const {
+	PyObject *attr = PyObject_GetAttrString(function, attr_name.c_str());
+	if (!attr) {
+		PyErr_Clear();
+		return false;
+	}
+	int is_set = PyObject_IsTrue(attr);
+	Py_DECREF(attr);
+	if (is_set < 0) {
+		PyErr_Clear();
+		return false;
+	}
+	return is_set;
+}
+
+PyObject *PythonFunction::return_annotation() const {
+	PyObject *annotations = PyObject_GetAttrString(function, "__annotations__");
+	if (!annotations) {
+		// Not every callable has annotations, classes with a __call__ method for instance
+		PyErr_Clear();
+		return nullptr;
+	}
+	PyObject *annotation = nullptr;
+	if (PyDict_Check(annotations)) {
+		// Borrowed reference
+		annotation = PyDict_GetItemString(annotations, "return");
+		Py_XINCREF(annotation);
+	}
+	Py_DECREF(annotations);
+	return annotation;
+}
+
+bool PythonFunction::is_coroutine_function() const {
+	PyObject *inspect = PyImport_ImportModule("inspect");
+	if (!inspect) {
+		PyErr_Clear();
+		return false;
+	}
+	PyObject *result = PyObject_CallMethod(inspect, "iscoroutinefunction", "O", function);
+	Py_DECREF(inspect);
+	if (!result) {
+		PyErr_Clear();
+		return false;
+	}
+	int is_coroutine = PyObject_IsTrue(result);
+	Py_DECREF(result);
+	if (is_coroutine < 0) {
+		PyErr_Clear();
+		return false;
+	}
+	return is_coroutine;
+}
+
 std::pair<std::string, std::string> parse_func_specifier(std::string specifier) {
 	auto delim_location = specifier.find(":");
 	if (delim_location == std::string::npos) {
@@ -221,4 +221,73 @@ std::vector<std::string> PythonTableFunction::column_names(PyObject *args, PyObj
 	return columnNames;
 }
 
+PyObject *PythonTableFunction::partitions(PyObject *args, PyObject *kwargs) {
+	PyObject *method = PyObject_GetAttrString(function, "partitions");
+	if (!method) {
+		// Not wrapped by the ducktables decorator
+		PyErr_Clear();
+		return nullptr;
+	}
+	PyObject *result = PyObject_Call(method, args, kwargs);
+	Py_DECREF(method);
+	if (!result) {
+		PythonException error;
+		throw std::runtime_error("Failed to list the partitions of '" + function_name() + "': " + error.message);
+	}
+	if (result == Py_None) {
+		Py_DECREF(result);
+		return nullptr;
+	}
+	PyObject *list = PySequence_List(result);
+	Py_DECREF(result);
+	if (!list) {
+		PythonException error;
+		throw std::runtime_error("Partitions of '" + function_name() + "' must be a sequence: " + error.message);
+	}
+	return list;
+}
+
+int64_t PythonTableFunction::estimated_rows(PyObject *args, PyObject *kwargs) {
+	PyObject *method = PyObject_GetAttrString(function, "estimated_rows");
+	if (!method) {
+		PyErr_Clear();
+		return -1;
+	}
+	PyObject *result = PyObject_Call(method, args, kwargs);
+	Py_DECREF(method);
+	if (!result) {
+		// Only a hint, a failing estimator shouldn't fail the query
+		PyErr_Clear();
+		return -1;
+	}
+	int64_t estimate = -1;
+	if (PyLong_Check(result)) {
+		estimate = PyLong_AsLongLong(result);
+		if (PyErr_Occurred()) {
+			PyErr_Clear();
+			estimate = -1;
+		}
+	}
+	Py_DECREF(result);
+	return estimate;
+}
+
+bool PythonTableFunction::accepts_keyword(const std::string &name) {
+	PyObject *method = PyObject_GetAttrString(function, "accepts_keyword");
+	if (!method) {
+		// Not wrapped by the ducktables decorator
+		PyErr_Clear();
+		return false;
+	}
+	PyObject *result = PyObject_CallFunction(method, "s", name.c_str());
+	Py_DECREF(method);
+	if (!result) {
+		PyErr_Clear();
+		return false;
+	}
+	bool accepts = PyObject_IsTrue(result) == 1;
+	Py_DECREF(result);
+	return accepts;
+}
+
 } // namespace pyudf
@@ -0,0 +1,517 @@
+#include <duckdb.hpp>
+#include <pyworker.hpp>
+#include <config.h>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using namespace duckdb;
+namespace pyudf {
+
+// Message layout shared with pythonpkgs/ducktables/ducktables/worker.py
+enum WorkerMessage : uint32_t { WORKER_CALL = 1, WORKER_DESCRIBE = 2 };
+enum WorkerStatus : uint32_t { WORKER_OK = 0, WORKER_ERROR = 1 };
+enum WorkerType : uint32_t { WORKER_BOOLEAN = 1, WORKER_BIGINT = 2, WORKER_DOUBLE = 3, WORKER_VARCHAR = 4 };
+
+// The worker finds the shared memory region on this file descriptor and its socket on stdin
+static const int WORKER_SHM_FD = 3;
+static const size_t WORKER_INITIAL_SHM_SIZE = 1 << 20;
+
+static WorkerType GetWorkerType(const LogicalType &type) {
+	switch (type.id()) {
+	case LogicalTypeId::BOOLEAN:
+		return WORKER_BOOLEAN;
+	case LogicalTypeId::TINYINT:
+	case LogicalTypeId::SMALLINT:
+	case LogicalTypeId::INTEGER:
+	case LogicalTypeId::BIGINT:
+	case LogicalTypeId::UTINYINT:
+	case LogicalTypeId::USMALLINT:
+	case LogicalTypeId::UINTEGER:
+		return WORKER_BIGINT;
+	case LogicalTypeId::FLOAT:
+	case LogicalTypeId::DOUBLE:
+		return WORKER_DOUBLE;
+	default:
+		// Everything else travels as its string representation
+		return WORKER_VARCHAR;
+	}
+}
+
+static LogicalType GetWorkerLogicalType(WorkerType type) {
+	switch (type) {
+	case WORKER_BOOLEAN:
+		return LogicalType::BOOLEAN;
+	case WORKER_BIGINT:
+		return LogicalType::BIGINT;
+	case WORKER_DOUBLE:
+		return LogicalType::DOUBLE;
+	case WORKER_VARCHAR:
+		return LogicalType::VARCHAR;
+	default:
+		throw IOException("Unknown column type " + std::to_string((uint32_t)type) + " from Python worker process");
+	}
+}
+
+static std::string GetWorkerPython() {
+	const char *python = std::getenv("PYTABLES_PYTHON");
+	return python ? python : PYTHON_EXECUTABLE_NAME;
+}
+
+static int CreateSharedMemory() {
+#ifdef __linux__
+	int fd = memfd_create("pytables-worker", MFD_CLOEXEC);
+#else
+	// No memfd, use a POSIX shared memory object that's unlinked right away
+	std::string name = "/pytables-" + std::to_string(getpid()) + "-" +
+	                   std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd >= 0) {
+		shm_unlink(name.c_str());
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+#endif
+	if (fd < 0) {
+		throw IOException("Failed to create shared memory for a Python worker process: " +
+		                  std::string(strerror(errno)));
+	}
+	if (fd == WORKER_SHM_FD) {
+		// dup2() onto itself wouldn't clear close-on-exec in the worker
+		int moved = fcntl(fd, F_DUPFD_CLOEXEC, WORKER_SHM_FD + 1);
+		close(fd);
+		fd = moved;
+	}
+	return fd;
+}
+
+// A Python worker process. The socket only carries the length of each message, the message
+// itself is in a shared memory region that both sides grow as needed.
+class WorkerProcess {
+public:
+	WorkerProcess() {
+		shm_fd = CreateSharedMemory();
+		Resize(WORKER_INITIAL_SHM_SIZE);
+
+		int sockets[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+			close(shm_fd);
+			munmap(data, size);
+			throw IOException("Failed to create a socket for a Python worker process: " +
+			                  std::string(strerror(errno)));
+		}
+		fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+		int on = 1;
+		setsockopt(sockets[0], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		posix_spawn_file_actions_adddup2(&actions, sockets[1], 0);
+		posix_spawn_file_actions_adddup2(&actions, shm_fd, WORKER_SHM_FD);
+		auto python = GetWorkerPython();
+		char *argv[] = {(char *)python.c_str(), (char *)"-m", (char *)"ducktables.worker", nullptr};
+		int err = posix_spawnp(&pid, python.c_str(), &actions, nullptr, argv, environ);
+		posix_spawn_file_actions_destroy(&actions);
+		close(sockets[1]);
+		if (err != 0) {
+			close(sockets[0]);
+			close(shm_fd);
+			munmap(data, size);
+			throw IOException("Failed to start Python worker process '" + python + "': " + std::string(strerror(err)));
+		}
+		socket_fd = sockets[0];
+	}
+
+	~WorkerProcess() {
+		// The worker exits once its socket is closed
+		close(socket_fd);
+		close(shm_fd);
+		munmap(data, size);
+		if (pid > 0) {
+			waitpid(pid, nullptr, 0);
+		}
+	}
+
+	// Makes sure the region holds at least 'required' bytes, which may move 'data'
+	void Reserve(size_t required) {
+		if (required > size) {
+			Resize(MaxValue<size_t>(required, size * 2));
+		}
+	}
+
+	// Sends the first 'length' bytes of the region and waits for the response, returning its length
+	size_t Exchange(size_t length) {
+		uint64_t header[2] = {length, size};
+		Send(header, sizeof(header));
+		Receive(header, sizeof(header));
+		if (header[1] != size) {
+			// The worker needed more room for its response
+			Map(header[1]);
+		}
+		return header[0];
+	}
+
+	bool Alive() const {
+		return pid > 0;
+	}
+
+	data_ptr_t data = nullptr;
+	size_t size = 0;
+
+private:
+	void Resize(size_t new_size) {
+		if (ftruncate(shm_fd, new_size) != 0) {
+			throw IOException("Failed to grow shared memory for a Python worker process: " +
+			                  std::string(strerror(errno)));
+		}
+		Map(new_size);
+	}
+
+	void Map(size_t new_size) {
+		if (data) {
+			munmap(data, size);
+		}
+		void *mapped = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+		if (mapped == MAP_FAILED) {
+			data = nullptr;
+			size = 0;
+			throw IOException("Failed to map shared memory for a Python worker process: " +
+			                  std::string(strerror(errno)));
+		}
+		data = (data_ptr_t)mapped;
+		size = new_size;
+	}
+
+	void Send(const void *buffer, size_t length) {
+		auto bytes = (const char *)buffer;
+		while (length > 0) {
+#ifdef MSG_NOSIGNAL
+			auto sent = send(socket_fd, bytes, length, MSG_NOSIGNAL);
+#else
+			auto sent = send(socket_fd, bytes, length, 0);
+#endif
+			if (sent < 0 && errno == EINTR) {
+				continue;
+			} else if (sent <= 0) {
+				Died();
+			}
+			bytes += sent;
+			length -= sent;
+		}
+	}
+
+	void Receive(void *buffer, size_t length) {
+		auto bytes = (char *)buffer;
+		while (length > 0) {
+			auto received = recv(socket_fd, bytes, length, 0);
+			if (received < 0 && errno == EINTR) {
+				continue;
+			} else if (received <= 0) {
+				Died();
+			}
+			bytes += received;
+			length -= received;
+		}
+	}
+
+	[[noreturn]] void Died() {
+		int status = 0;
+		std::string reason;
+		if (waitpid(pid, &status, 0) == pid) {
+			if (WIFSIGNALED(status)) {
+				reason = " (signal " + std::to_string(WTERMSIG(status)) + ")";
+			} else if (WIFEXITED(status)) {
+				reason = " (exit code " + std::to_string(WEXITSTATUS(status)) + ")";
+			}
+		}
+		pid = -1;
+		throw std::runtime_error("Python worker process exited unexpectedly" + reason);
+	}
+
+	pid_t pid = -1;
+	int socket_fd = -1;
+	int shm_fd = -1;
+};
+
+// Worker processes shared by every database in this process. Workers are started on demand up
+// to the requested pool size and stay around until the process exits.
+class WorkerPool {
+public:
+	static WorkerPool &Get() {
+		static WorkerPool pool;
+		return pool;
+	}
+
+	unique_ptr<WorkerProcess> Acquire(idx_t pool_size) {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			if (!idle.empty()) {
+				auto worker = std::move(idle.back());
+				idle.pop_back();
+				return worker;
+			}
+			if (running < pool_size) {
+				running++;
+				lock.unlock();
+				try {
+					return make_uniq<WorkerProcess>();
+				} catch (...) {
+					lock.lock();
+					running--;
+					available.notify_one();
+					throw;
+				}
+			}
+			available.wait(lock);
+		}
+	}
+
+	void Release(unique_ptr<WorkerProcess> worker, idx_t pool_size) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (worker->Alive() && running <= pool_size) {
+				idle.push_back(std::move(worker));
+			} else {
+				// Crashed, or the pool was made smaller since this worker started
+				running--;
+			}
+			available.notify_one();
+		}
+		worker.reset();
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable available;
+	std::vector<unique_ptr<WorkerProcess>> idle;
+	idx_t running = 0;
+};
+
+// Holds a worker for the duration of one request
+struct WorkerLease {
+	explicit WorkerLease(idx_t pool_size) : pool_size(pool_size) {
+		worker = WorkerPool::Get().Acquire(pool_size);
+	}
+	~WorkerLease() {
+		WorkerPool::Get().Release(std::move(worker), pool_size);
+	}
+
+	idx_t pool_size;
+	unique_ptr<WorkerProcess> worker;
+};
+
+struct WorkerWriter {
+	explicit WorkerWriter(WorkerProcess &worker) : worker(worker) {
+	}
+
+	void Write(const void *bytes, size_t length) {
+		worker.Reserve(offset + length);
+		memcpy(worker.data + offset, bytes, length);
+		offset += length;
+	}
+
+	template <class T>
+	void Write(T value) {
+		Write(&value, sizeof(T));
+	}
+
+	void WriteString(const std::string &value) {
+		Write<uint32_t>(value.size());
+		Write(value.data(), value.size());
+	}
+
+	WorkerProcess &worker;
+	size_t offset = 0;
+};
+
+struct WorkerReader {
+	WorkerReader(WorkerProcess &worker, size_t length) : worker(worker), length(length) {
+	}
+
+	const_data_ptr_t Read(size_t count) {
+		if (offset + count > length) {
+			throw IOException("Truncated response from Python worker process");
+		}
+		auto bytes = worker.data + offset;
+		offset += count;
+		return bytes;
+	}
+
+	template <class T>
+	T Read() {
+		T value;
+		memcpy(&value, Read(sizeof(T)), sizeof(T));
+		return value;
+	}
+
+	std::string ReadString() {
+		auto count = Read<uint32_t>();
+		return std::string((const char *)Read(count), count);
+	}
+
+	WorkerProcess &worker;
+	size_t length;
+	size_t offset = 0;
+};
+
+// Column layout: type, one validity byte per row, then the values. VARCHAR values are
+// count + 1 offsets followed by the concatenated UTF-8 strings.
+static void WriteColumn(WorkerWriter &writer, Vector &input, idx_t count) {
+	auto type = GetWorkerType(input.GetType());
+	auto logical_type = GetWorkerLogicalType(type);
+	Vector converted(logical_type, count);
+	Vector *source = &input;
+	if (input.GetType() != logical_type) {
+		VectorOperations::DefaultCast(input, converted, count);
+		source = &converted;
+	}
+	UnifiedVectorFormat format;
+	source->ToUnifiedFormat(count, format);
+
+	writer.Write<uint32_t>(type);
+	for (idx_t row = 0; row < count; row++) {
+		writer.Write<uint8_t>(format.validity.RowIsValid(format.sel->get_index(row)));
+	}
+	switch (type) {
+	case WORKER_BOOLEAN: {
+		auto values = (bool *)format.data;
+		for (idx_t row = 0; row < count; row++) {
+			writer.Write<uint8_t>(values[format.sel->get_index(row)]);
+		}
+		break;
+	}
+	case WORKER_BIGINT: {
+		auto values = (int64_t *)format.data;
+		for (idx_t row = 0; row < count; row++) {
+			writer.Write<int64_t>(values[format.sel->get_index(row)]);
+		}
+		break;
+	}
+	case WORKER_DOUBLE: {
+		auto values = (double *)format.data;
+		for (idx_t row = 0; row < count; row++) {
+			writer.Write<double>(values[format.sel->get_index(row)]);
+		}
+		break;
+	}
+	case WORKER_VARCHAR: {
+		auto values = (string_t *)format.data;
+		uint64_t end = 0;
+		writer.Write<uint64_t>(end);
+		for (idx_t row = 0; row < count; row++) {
+			auto idx = format.sel->get_index(row);
+			if (format.validity.RowIsValid(idx)) {
+				end += values[idx].GetSize();
+			}
+			writer.Write<uint64_t>(end);
+		}
+		for (idx_t row = 0; row < count; row++) {
+			auto idx = format.sel->get_index(row);
+			if (format.validity.RowIsValid(idx)) {
+				writer.Write(values[idx].GetData(), values[idx].GetSize());
+			}
+		}
+		break;
+	}
+	}
+}
+
+static void ReadColumn(WorkerReader &reader, Vector &result, idx_t count) {
+	auto type = (WorkerType)reader.Read<uint32_t>();
+	auto logical_type = GetWorkerLogicalType(type);
+	Vector converted(logical_type, count);
+	Vector &target = result.GetType() == logical_type ? result : converted;
+
+	auto valid = reader.Read(count);
+	auto &validity = FlatVector::Validity(target);
+	for (idx_t row = 0; row < count; row++) {
+		if (!valid[row]) {
+			validity.SetInvalid(row);
+		}
+	}
+	switch (type) {
+	case WORKER_BOOLEAN: {
+		auto values = reader.Read(count);
+		auto data = FlatVector::GetData<bool>(target);
+		for (idx_t row = 0; row < count; row++) {
+			data[row] = values[row] != 0;
+		}
+		break;
+	}
+	case WORKER_BIGINT:
+		memcpy(FlatVector::GetData<int64_t>(target), reader.Read(count * sizeof(int64_t)), count * sizeof(int64_t));
+		break;
+	case WORKER_DOUBLE:
+		memcpy(FlatVector::GetData<double>(target), reader.Read(count * sizeof(double)), count * sizeof(double));
+		break;
+	case WORKER_VARCHAR: {
+		std::vector<uint64_t> offsets(count + 1);
+		memcpy(offsets.data(), reader.Read((count + 1) * sizeof(uint64_t)), (count + 1) * sizeof(uint64_t));
+		auto strings = (const char *)reader.Read(offsets[count]);
+		auto data = FlatVector::GetData<string_t>(target);
+		for (idx_t row = 0; row < count; row++) {
+			if (valid[row]) {
+				data[row] = StringVector::AddString(target, strings + offsets[row], offsets[row + 1] - offsets[row]);
+			}
+		}
+		break;
+	}
+	}
+	if (&target != &result) {
+		VectorOperations::DefaultCast(converted, result, count);
+	}
+}
+
+void CallInWorkerProcess(const std::string &function_specifier, idx_t pool_size, DataChunk &args, idx_t first_column,
+                         Vector &result) {
+	auto count = args.size();
+	WorkerLease lease(pool_size);
+	auto &worker = *lease.worker;
+
+	WorkerWriter writer(worker);
+	writer.Write<uint32_t>(WORKER_CALL);
+	writer.WriteString(function_specifier);
+	writer.Write<uint32_t>(GetWorkerType(result.GetType()));
+	writer.Write<uint32_t>(args.ColumnCount() - first_column);
+	writer.Write<uint64_t>(count);
+	for (idx_t i = first_column; i < args.ColumnCount(); i++) {
+		WriteColumn(writer, args.data[i], count);
+	}
+
+	WorkerReader reader(worker, worker.Exchange(writer.offset));
+	if (reader.Read<uint32_t>() != WORKER_OK) {
+		throw std::runtime_error(reader.ReadString());
+	}
+	ReadColumn(reader, result, count);
+}
+
+std::string DescribeInWorkerProcess(const std::string &function_specifier, idx_t pool_size) {
+	WorkerLease lease(pool_size);
+	auto &worker = *lease.worker;
+
+	WorkerWriter writer(worker);
+	writer.Write<uint32_t>(WORKER_DESCRIBE);
+	writer.WriteString(function_specifier);
+
+	WorkerReader reader(worker, worker.Exchange(writer.offset));
+	auto status = reader.Read<uint32_t>();
+	auto message = reader.ReadString();
+	if (status != WORKER_OK) {
+		throw std::runtime_error(message);
+	}
+	return message;
+}
+} // namespace pyudf
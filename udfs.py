@@ -1,5 +1,13 @@
 
-from typing import Iterable, Tuple
+import array
+import asyncio
+import dataclasses
+import datetime
+import decimal
+import importlib.util
+import os
+import uuid
+from typing import Iterable, NamedTuple, Tuple
 
 # Scalar Functions
 def reverse(input):
@@ -17,7 +25,50 @@ def fizzbuzz(i):
         return 'buzz'
     else:
         return str(i)
-    
+
+# Takes down the whole process, only safe to call with pytables_isolation = 'process'
+def crash(i):
+    os.abort()
+
+# Scalar functions with a return annotation produce typed results instead of VARCHAR
+def add_one(i) -> int:
+    return i + 1
+
+def half(i) -> float:
+    return i / 2
+
+def is_even(i) -> 'BOOLEAN':
+    return (i % 2) == 0
+
+# Vectorized Scalar Functions, these receive one list per argument column
+def reverse_vectorized(inputs):
+    return [reverse(i) for i in inputs]
+
+def concat_vectorized(lefts, rights):
+    return [l + r for l, r in zip(lefts, rights)]
+
+def vectorized_wrong_length(inputs):
+    return inputs[1:]
+
+# Vectorized functions flagged with 'pytables_buffers' receive INTEGER, BIGINT and DOUBLE
+# columns as a (memoryview, validity) pair and may return a buffer of results.
+def add_one_buffers(values) -> float:
+    data, validity = values
+    return array.array('d', [v + 1 for v in data])
+add_one_buffers.pytables_buffers = True
+
+def null_flags_buffers(values) -> int:
+    data, validity = values
+    if validity is None:
+        return [0] * len(data)
+    return [0 if (validity[i // 64] >> (i % 64)) & 1 else 1 for i in range(len(data))]
+null_flags_buffers.pytables_buffers = True
+
+def wrong_format_buffers(values) -> float:
+    data, validity = values
+    return array.array('i', [1] * len(data))
+wrong_format_buffers.pytables_buffers = True
+
 # Table Functions
 def table(input):
     for char in "a very long string":
@@ -47,6 +98,37 @@ def table2(one_str_input, two_str_input, three_int_input):
     yield [str(three_int_input)]
 
 
+def arrow_table(num_rows):
+    """Returns a pyarrow Table, which pytable scans through the Arrow C stream interface"""
+    import pyarrow as pa
+    ids = list(range(int(num_rows)))
+    return pa.table({'id': ids, 'name': [f'row{i}' for i in ids]})
+
+def arrow_reader(num_rows):
+    """Returns a pyarrow RecordBatchReader yielding batches of up to 1000 rows"""
+    import pyarrow as pa
+    table = arrow_table(num_rows)
+    return pa.RecordBatchReader.from_batches(table.schema, table.to_batches(max_chunksize=1000))
+
+def dataframe_rows(num_rows):
+    """Returns a pandas DataFrame, which pytable scans column by column through __dataframe__()"""
+    import pandas as pd
+    ids = list(range(int(num_rows)))
+    return pd.DataFrame({
+        'id': ids,
+        'score': [i / 2 if i % 3 else None for i in ids],
+        'name': [f'row{i}' for i in ids],
+        'flag': [i % 2 == 0 for i in ids],
+    })
+
+def dataframe_objects():
+    """A DataFrame whose 'big' column holds Python ints as objects, the first of them None"""
+    import pandas as pd
+    return pd.DataFrame({
+        'id': [0, 1, 2],
+        'big': pd.Series([None, 2 ** 40, -7], dtype=object),
+    })
+
 def table_throws_exception(input):
     raise Exception("This function raises an exception")
 
@@ -71,6 +153,48 @@ def num_columns(val, num_rows, num_cols):
             row.append(val)
         yield row
 
+def range_rows(num_rows):
+    """Rows that are neither tuples nor lists"""
+    for i in range(num_rows):
+        yield range(i, i + 2)
+
+def dict_rows(num_rows):
+    """Rows as dicts, in a different key order than the columns and without 'age' in the last row"""
+    for i in range(num_rows - 1):
+        yield {'age': i, 'name': f'person{i}', 'unused': True}
+    yield {'name': 'nobody'}
+
+class Person(NamedTuple):
+    name: str
+    age: int
+
+def person_rows(num_rows) -> Iterable[Person]:
+    for i in range(num_rows):
+        yield Person(f'person{i}', i)
+
+@dataclasses.dataclass
+class Point:
+    __slots__ = ('x', 'y')
+    x: float
+    y: float
+
+def point_rows(num_rows) -> Iterable[Point]:
+    for i in range(num_rows):
+        yield Point(i / 2, -i)
+
+def batched_range(num_rows, batch_size):
+    """Yields (i, str(i)) rows as batches of columns, every other one as a dict"""
+    for start in range(0, num_rows, batch_size):
+        numbers = range(start, min(start + batch_size, num_rows))
+        if (start // batch_size) % 2:
+            yield {'s': [str(i) for i in numbers], 'i': numbers}
+        else:
+            yield (list(numbers), tuple(str(i) for i in numbers))
+        # Empty batches are skipped
+        yield ([], [])
+
+batched_range.pytables_batched = True
+
 def sentence_to_columns(sentence, rows):
     """
     Generates a table with a column for each word in 'sentence'. Will
@@ -83,6 +207,166 @@ def screaming_in_the_void():
     """Example function with no arguments for testing"""
     return table("foo bar")
 
+def partitioned_range(num_partitions, rows_per_partition, partition=None):
+    """
+    Yields (partition, i) rows. Lists one partition per number below 'num_partitions', which
+    DuckDB then scans in parallel, calling this once per partition.
+    """
+    for i in range(int(rows_per_partition)):
+        yield (partition, i)
+
+partitioned_range.partitions = lambda num_partitions, rows_per_partition: range(int(num_partitions))
+
+def lettered_columns(num_rows, columns=None):
+    """
+    Yields rows with columns 'a', 'b' and 'c', where row i of column 'a' is 'a<i>'. When DuckDB
+    passes the projected 'columns', only those are built, in the order they're asked for.
+    """
+    names = columns if columns is not None else ['a', 'b', 'c']
+    for i in range(int(num_rows)):
+        yield tuple(f'{name}{i}' for name in names)
+
+def describe_filters(num_rows, claim_handled=False, filters=None):
+    """
+    Yields (i, description) rows, where description lists the filters DuckDB passed in. With
+    'claim_handled' every filter is marked handled without being applied, so DuckDB skips it.
+    """
+    description = '; '.join(
+        f"{f['column']} {f['op']} {f.get('value', f.get('values', ''))}".strip() for f in filters or [])
+    for f in filters or []:
+        if claim_handled:
+            f['handled'] = True
+    for i in range(int(num_rows)):
+        yield (i, description)
+
+closed_generators = []
+
+def tracked_range(name, num_rows, limit=None):
+    """
+    Yields (i, limit) rows, where 'limit' is the hint pytable passes along. Records 'name' in
+    closed_generators once the generator is closed.
+    """
+    try:
+        for i in range(int(num_rows)):
+            yield (i, limit)
+    finally:
+        closed_generators.append(name)
+
+def was_closed(name) -> 'BOOLEAN':
+    return name in closed_generators
+
+def estimated_range(num_rows):
+    """Yields (i,) rows, and tells DuckDB up front how many there will be"""
+    for i in range(int(num_rows)):
+        yield (i,)
+
+estimated_range.estimated_rows = lambda num_rows: int(num_rows)
+
+def list_iterator_range(num_rows):
+    """Returns a list iterator, whose __length_hint__ serves as the row estimate"""
+    return iter([(i,) for i in range(int(num_rows))])
+
+call_counts = {}
+
+def counted_range(name, num_rows):
+    """Yields (i, name) rows, counting the calls made under 'name' in call_counts"""
+    call_counts[name] = call_counts.get(name, 0) + 1
+    for i in range(int(num_rows)):
+        yield (i, name)
+
+def call_count(name) -> int:
+    return call_counts.get(name, 0)
+
+def memoized_label(code) -> str:
+    """Counts its calls under the 'memoized_label' name in call_counts"""
+    call_counts['memoized_label'] = call_counts.get('memoized_label', 0) + 1
+    return None if code is None else f"label-{code}"
+
+memoized_label.pytables_memoize = True
+
+async def memoized_async_label(code) -> str:
+    """Counts its calls under the 'memoized_async_label' name in call_counts"""
+    call_counts['memoized_async_label'] = call_counts.get('memoized_async_label', 0) + 1
+    await asyncio.sleep(0)
+    return None if code is None else f"label-{code}"
+
+memoized_async_label.pytables_memoize = True
+
+def counted_upper(s) -> str:
+    """Counts its calls under the 'counted_upper' name in call_counts"""
+    call_counts['counted_upper'] = call_counts.get('counted_upper', 0) + 1
+    return s.upper()
+
+async_calls = {'in_flight': 0, 'max_in_flight': 0}
+
+async def slow_double(i) -> int:
+    """Sleeps like an API call would, recording how many calls overlapped"""
+    async_calls['in_flight'] += 1
+    async_calls['max_in_flight'] = max(async_calls['max_in_flight'], async_calls['in_flight'])
+    try:
+        await asyncio.sleep(0.01)
+        if i is not None and i < 0:
+            raise ValueError("negative input")
+        return None if i is None else i * 2
+    finally:
+        async_calls['in_flight'] -= 1
+
+def max_in_flight() -> int:
+    return async_calls['max_in_flight']
+
+async def async_range(num_rows):
+    for i in range(int(num_rows)):
+        await asyncio.sleep(0)
+        yield (i,)
+
+def typed_values():
+    """One row of each type pytable converts natively, and a row of nulls"""
+    yield (datetime.date(2024, 2, 29),
+           datetime.datetime(2024, 2, 29, 13, 45, 30, 123456),
+           datetime.datetime(2024, 2, 29, 13, 45, 30, tzinfo=datetime.timezone(datetime.timedelta(hours=2))),
+           datetime.time(13, 45, 30, 5),
+           decimal.Decimal('1234.5678'),
+           b'\x00\xffab',
+           uuid.UUID('12345678-1234-5678-1234-567812345678'),
+           2**40)
+    yield (None,) * 8
+
+def decimal_bounds(digits):
+    """Ints and Decimals with 'digits' digits, at and just beyond the edges of DECIMAL(digits, 0)"""
+    largest = 10 ** int(digits) - 1
+    for value in (largest, -largest, largest + 1, 2 ** 64 + 1, decimal.Decimal(largest), decimal.Decimal('1E+37')):
+        yield (value,)
+
+def decimal_annotated(value) -> decimal.Decimal:
+    return decimal.Decimal(value)
+
+def describe_value(value) -> str:
+    return f"{type(value).__name__} {value}"
+
+def next_day(date) -> 'DATE':
+    return date + datetime.timedelta(days=1)
+
+def as_float(i) -> float:
+    """Returns its argument unchanged, so ints have to be coerced into the DOUBLE result"""
+    return i
+
+BENCHMARK_VALUES = {
+    'int': int,
+    'float': float,
+    'str': str,
+    'date': lambda i: datetime.date.fromordinal(730000 + i % 10000),
+}
+
+def benchmark_rows(kind, num_rows):
+    """Rows of four values of one kind, see scripts/benchmark-conversions.sh"""
+    make = BENCHMARK_VALUES[kind]
+    for i in range(num_rows):
+        value = make(i)
+        yield (value, value, value, value)
+
+def count_args(*args) -> int:
+    return len(args)
+
 import unittest
 
 class TestUdfs(unittest.TestCase):
@@ -90,6 +374,27 @@ class TestUdfs(unittest.TestCase):
     def test_reverse(self):
         self.assertEqual("raboof", reverse("foobar"))
 
+    def test_typed_results(self):
+        self.assertEqual(2, add_one(1))
+        self.assertEqual(1.5, half(3))
+        self.assertTrue(is_even(4))
+
+    def test_reverse_vectorized(self):
+        self.assertEqual(["raboof", "zab"], reverse_vectorized(["foobar", "baz"]))
+
+    def test_concat_vectorized(self):
+        self.assertEqual(["ab", "cd"], concat_vectorized(["a", "c"], ["b", "d"]))
+
+    def test_add_one_buffers(self):
+        values = memoryview(array.array('d', [1.5, 2.5]))
+        self.assertEqual([2.5, 3.5], list(add_one_buffers((values, None))))
+
+    def test_null_flags_buffers(self):
+        values = memoryview(array.array('i', [1, 2, 3]))
+        validity = memoryview(array.array('Q', [0b101]))
+        self.assertEqual([0, 1, 0], null_flags_buffers((values, validity)))
+        self.assertEqual([0, 0, 0], null_flags_buffers((values, None)))
+
     def test_table(self):
         actual = [record[0] for record in table("")]
         expected = ["a", " ", "v", "e", "r", "y", " ", "l", "o", "n", "g", " ", "s", "t", "r", "i", "n", "g"]
@@ -100,6 +405,18 @@ class TestUdfs(unittest.TestCase):
         expected = ['f', 'o', 'o', 'b', 'a', 'r', '16']
         self.assertEqual(actual, expected)
 
+    @unittest.skipUnless(importlib.util.find_spec('pyarrow'), 'requires pyarrow')
+    def test_arrow_reader(self):
+        table = arrow_reader(2500).read_all()
+        self.assertEqual(2500, table.num_rows)
+        self.assertEqual(['id', 'name'], table.column_names)
+
+    @unittest.skipUnless(importlib.util.find_spec('pandas'), 'requires pandas')
+    def test_dataframe_rows(self):
+        frame = dataframe_rows(4)
+        self.assertEqual(['id', 'score', 'name', 'flag'], list(frame.columns))
+        self.assertEqual(['row0', 'row1', 'row2', 'row3'], frame['name'].tolist())
+
     def test_table_throws_exception(self):
         try:
             table_throws_exception("")
@@ -122,6 +439,86 @@ class TestUdfs(unittest.TestCase):
         expected = [[0, 'f'], [1, 'o'], [2, 'o']]
         self.assertEqual(actual, expected)
 
+    def test_partitioned_range(self):
+        self.assertEqual([0, 1, 2], list(partitioned_range.partitions(3, 2)))
+        self.assertEqual([(1, 0), (1, 1)], list(partitioned_range(3, 2, partition=1)))
+
+    def test_lettered_columns(self):
+        self.assertEqual([('a0', 'b0', 'c0'), ('a1', 'b1', 'c1')], list(lettered_columns(2)))
+        self.assertEqual([('c0', 'a0')], list(lettered_columns(1, columns=['c', 'a'])))
+        self.assertEqual([(), ()], list(lettered_columns(2, columns=[])))
+
+    def test_describe_filters(self):
+        filters = [{'column': 'i', 'op': '=', 'value': 1}, {'column': 'i', 'op': 'in', 'values': [1, 2]}]
+        self.assertEqual([(0, 'i = 1; i in [1, 2]')], list(describe_filters(1, filters=filters)))
+        self.assertNotIn('handled', filters[0])
+        list(describe_filters(1, True, filters=filters))
+        self.assertTrue(filters[0]['handled'])
+
+    def test_tracked_range(self):
+        rows = tracked_range('test', 10, limit=2)
+        self.assertEqual((0, 2), next(rows))
+        self.assertFalse(was_closed('test'))
+        rows.close()
+        self.assertTrue(was_closed('test'))
+
+    def test_estimated_range(self):
+        self.assertEqual(3, estimated_range.estimated_rows(3))
+        self.assertEqual([(0,), (1,), (2,)], list(estimated_range(3)))
+        self.assertEqual(3, list_iterator_range(3).__length_hint__())
+
+    def test_counted_range(self):
+        self.assertEqual(0, call_count('test'))
+        self.assertEqual([(0, 'test'), (1, 'test')], list(counted_range('test', 2)))
+        self.assertEqual(1, call_count('test'))
+
+    def test_memoized_label(self):
+        self.assertTrue(memoized_label.pytables_memoize)
+        self.assertEqual('label-1', memoized_label(1))
+        self.assertIsNone(memoized_label(None))
+
+    def test_counted_upper(self):
+        self.assertEqual('AB', counted_upper('ab'))
+        self.assertEqual(1, call_count('counted_upper'))
+
+    def test_slow_double(self):
+        self.assertEqual(4, asyncio.run(slow_double(2)))
+        self.assertIsNone(asyncio.run(slow_double(None)))
+        with self.assertRaises(ValueError):
+            asyncio.run(slow_double(-1))
+
+    def test_async_range(self):
+        async def collect():
+            return [row async for row in async_range(3)]
+        self.assertEqual([(0,), (1,), (2,)], asyncio.run(collect()))
+
+    def test_typed_values(self):
+        rows = list(typed_values())
+        self.assertEqual(2, len(rows))
+        self.assertEqual(8, len(rows[0]))
+        self.assertEqual((None,) * 8, rows[1])
+
+    def test_describe_value(self):
+        self.assertEqual('date 2024-02-29', describe_value(datetime.date(2024, 2, 29)))
+        self.assertEqual('NoneType None', describe_value(None))
+
+    def test_next_day(self):
+        self.assertEqual(datetime.date(2024, 3, 1), next_day(datetime.date(2024, 2, 29)))
+
+    def test_benchmark_rows(self):
+        self.assertEqual([(0.0,) * 4, (1.0,) * 4], list(benchmark_rows('float', 2)))
+        self.assertEqual(4, count_args(*next(benchmark_rows('date', 1))))
+
+    def test_object_rows(self):
+        self.assertEqual({'name': 'nobody'}, list(dict_rows(1))[0])
+        self.assertEqual(Person('person1', 1), list(person_rows(2))[1])
+        self.assertEqual(Point(0.5, -1), list(point_rows(2))[1])
+
+    def test_batched_range(self):
+        batches = list(batched_range(3, 2))
+        self.assertEqual(([0, 1], ('0', '1')), batches[0])
+        self.assertEqual({'s': ['2'], 'i': range(2, 3)}, batches[2])
+
     def test_num_columns(self):
         actual = list(num_columns('x', 2, 3))
         expected = [